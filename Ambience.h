@@ -7,6 +7,15 @@
 #include "EnvFollower.h"
 #include "DcBlockingFilter.h"
 #include "Compressor.h"
+#include "Halfband.h"
+#include "FastFourierTransform.h"
+#include "ComplexFloatArray.h"
+
+#ifdef USE_AMBIENCE_HALF_RATE
+constexpr int kAmbienceRateDivider = 2;
+#else
+constexpr int kAmbienceRateDivider = 1;
+#endif
 
 class Damp
 {
@@ -95,34 +104,50 @@ public:
     }
 }; // End Damp
 
+typedef MaskedStereoDelayLine<SATURATE_ON_WRITE> DiffuseDelayLine;
+
+/**
+ * @brief Both channels of the diffusion network. They share the delay
+ *        times and the coefficients, so each stage stores them as
+ *        interleaved frames and processes both lanes together.
+ */
 class Diffuse
 {
 public:
-    Diffuse()
+    Diffuse(int blockSize, float sampleRate)
     {
+        sampleRate_ = sampleRate;
         for (int i = 0; i < kAmbienceNofDiffusers; i++)
         {
-            diffuse_[i] = DelayLine::create(kAmbienceBufferSize);
+            // Room for the interpolation sample.
+            diffuse_[i] = DiffuseDelayLine::create(GetMaxDelay(i, sampleRate_) + 2);
+            reads_[i] = FloatArray::create((blockSize + 1) * 2);
+            reads_[i].clear();
         }
+        stage_ = FloatArray::create(blockSize * 2);
 
-        fbOut_ = 0;
+        fbOuts_[LEFT_CHANNEL] = fbOuts_[RIGHT_CHANNEL] = 0;
         df_ = 0;
+        time_ = 0;
         needsUpdate_ = false;
 
         SetSZ(1);
+        UpdateDelayTimes();
         SetRT(0);
     }
     ~Diffuse()
     {
         for (int i = 0; i < kAmbienceNofDiffusers; i++)
         {
-            DelayLine::destroy(diffuse_[i]);
+            DiffuseDelayLine::destroy(diffuse_[i]);
+            FloatArray::destroy(reads_[i]);
         }
+        FloatArray::destroy(stage_);
     }
 
-    static Diffuse* create()
+    static Diffuse* create(int blockSize, float sampleRate)
     {
-        return new Diffuse();
+        return new Diffuse(blockSize, sampleRate);
     }
 
     static void destroy(Diffuse* diffuse)
@@ -130,15 +155,53 @@ public:
         delete diffuse;
     }
 
+    static int GetNofStages()
+    {
+        return kAmbienceNofDiffusers;
+    }
+
+    /**
+     * @brief Worst case delay of a stage, with the smallest size.
+     */
+    static float GetMaxDelay(int stage, float sampleRate)
+    {
+        if (stage == kAmbienceNofDiffusers - 1)
+        {
+            return M2D(kAmbienceDiffuseSizeMin - 7.f, sampleRate);
+        }
+
+        return M2D(kAmbienceDiffuseSizeMin + 2.f * (stage + 1), sampleRate);
+    }
+
+    // Allocated memory of a stage for both channels, in bytes.
+    uint32_t GetStageMemory(int stage)
+    {
+        return diffuse_[stage]->getSize() * 2 * sizeof(float);
+    }
+
+    uint32_t GetMemory()
+    {
+        uint32_t bytes = 0;
+        for (int i = 0; i < kAmbienceNofDiffusers; i++)
+        {
+            bytes += GetStageMemory(i);
+        }
+
+        return bytes;
+    }
+
+    /**
+     * @param size Lower is longer, down to kAmbienceDiffuseSizeMin
+     */
     void SetSZ(float size)
     {
         size_ = size;
         for (size_t i = 0; i < kAmbienceNofDiffusers - 1; i++)
         {
-            newDelayTimes_[i] = M2D(size + 2.f * (i + 1));
+            newDelayTimes_[i] = M2D(size + 2.f * (i + 1), sampleRate_);
         }
 
-        newDelayTimes_[kAmbienceNofDiffusers - 1] = M2D(size - 7.f);
+        newDelayTimes_[kAmbienceNofDiffusers - 1] = M2D(size - 7.f, sampleRate_);
         SetRT(time_);
         needsUpdate_ = true;
     }
@@ -146,7 +209,7 @@ public:
     void SetRT(float time)
     {
         time_ = time;
-        rt_ = Db2A((delayTimes_[kAmbienceNofDiffusers - 1] / M2D(time)) * -60.f);
+        rt_ = Db2A((delayTimes_[kAmbienceNofDiffusers - 1] / M2D(time, sampleRate_)) * -60.f);
         if (rt_ >= kOne) {
             rt_ = 1.f;
         }
@@ -157,9 +220,13 @@ public:
         df_ = _df;
     }
 
-    float GetFbOut()
+    /**
+     * @brief Feedback output of a channel seen by the sample at position i
+     *        of the block being processed.
+     */
+    float GetFbOut(int channel, size_t i)
     {
-        return fbOut_;
+        return i == 0 ? fbOuts_[channel] : reads_[kAmbienceNofDiffusers - 1][((i - 1) << 1) + channel] * rt_;
     }
 
     void UpdateDelayTimes()
@@ -174,35 +241,703 @@ public:
             delayTimes_[i] = newDelayTimes_[i];
         }
         needsUpdate_ = false;
+
+        // The decay depends on the last delay time, refresh it now rather
+        // than waiting for the next SetRT().
+        SetRT(time_);
+    }
+
+    /**
+     * @brief Reads the delayed outputs of all the stages for the next block,
+     *        crossfading from the current to the new delay times starting
+     *        at x. Every delay is longer than a block, so they only depend
+     *        on what was written in previous blocks.
+     */
+    void PrepareBlock(size_t size, float x, float xi)
+    {
+        // Each stage reads right after being written, one sample later
+        // than the block read assumes.
+        for (int i = 0; i < kAmbienceNofDiffusers; i++)
+        {
+            diffuse_[i]->readBlock(reads_[i].subArray(2, size * 2), delayTimes_[i] - 1.f, newDelayTimes_[i] - 1.f, x, xi);
+        }
     }
 
-    float Process(const float in, const float x)
+    // Processes in place the block prepared with PrepareBlock(), one stage
+    // at a time.
+    void Process(FloatArray left, FloatArray right)
     {
-        float out = in;
+        size_t size = left.getSize();
+        float* io[2] = { left.getData(), right.getData() };
 
         for (int i = 0; i < kAmbienceNofDiffusers - 1; i++)
         {
-            float prev = HardClip(out - outs_[i] * df_);
-            diffuse_[i]->write(prev);
-            out = HardClip(prev * df_ + outs_[i]);
-            outs_[i] = diffuse_[i]->read(delayTimes_[i], newDelayTimes_[i], x);
+            float* outs = reads_[i].getData();
+            float* stage = stage_.getData();
+            for (size_t j = 0; j < size; j++)
+            {
+                for (int c = 0; c < 2; c++)
+                {
+                    float prev = HardClip(io[c][j] - outs[c] * df_);
+                    stage[c] = prev;
+                    io[c][j] = HardClip(prev * df_ + outs[c]);
+                }
+                outs += 2;
+                stage += 2;
+            }
+            diffuse_[i]->writeBlock(stage_.subArray(0, size * 2));
+            // Carry the last frame over.
+            reads_[i][0] = outs[0];
+            reads_[i][1] = outs[1];
         }
 
         int lastDiff = kAmbienceNofDiffusers - 1;
-        fbOut_ = outs_[lastDiff] * rt_;
-        diffuse_[lastDiff]->write(out);
-        outs_[lastDiff] = diffuse_[lastDiff]->read(delayTimes_[lastDiff], newDelayTimes_[lastDiff], x);
-
-        return out;
+        FloatArray lastReads = reads_[lastDiff];
+        for (size_t j = 0; j < size; j++)
+        {
+            stage_[j << 1] = io[LEFT_CHANNEL][j];
+            stage_[(j << 1) + 1] = io[RIGHT_CHANNEL][j];
+        }
+        fbOuts_[LEFT_CHANNEL] = lastReads[(size - 1) << 1] * rt_;
+        fbOuts_[RIGHT_CHANNEL] = lastReads[((size - 1) << 1) + 1] * rt_;
+        diffuse_[lastDiff]->writeBlock(stage_.subArray(0, size * 2));
+        lastReads[0] = lastReads[size << 1];
+        lastReads[1] = lastReads[(size << 1) + 1];
     }
 
 private:
-    DelayLine *diffuse_[kAmbienceNofDiffusers];
+    DiffuseDelayLine *diffuse_[kAmbienceNofDiffusers];
+    // Delayed output frames of each stage, frame 0 carries the last one of
+    // the previous block.
+    FloatArray reads_[kAmbienceNofDiffusers];
+    FloatArray stage_;
     float delayTimes_[kAmbienceNofDiffusers], newDelayTimes_[kAmbienceNofDiffusers];
-    float size_, time_, rt_, df_, fbOut_, outs_[kAmbienceNofDiffusers];
+    float sampleRate_, size_, time_, rt_, df_;
+    float fbOuts_[2];
     bool needsUpdate_;
 }; // End Diffuse
 
+/**
+ * @brief Lighter alternative to Diffuse, a stereo feedback delay network of
+ *        kAmbienceFdnNofLines lines mixed by a Hadamard matrix. Even lines
+ *        take the left input and make the left output, odd ones the right.
+ *        The decay is inside the network, so unlike Diffuse there's no
+ *        feedback output: Ambience only damps what goes in. Every line is
+ *        longer than a block, so a whole block of the line outputs can be
+ *        read before computing the block.
+ *        Size and decay work as with Diffuse, SetDf() and GetFbOut() are
+ *        no-ops kept for the common interface.
+ */
+class Fdn
+{
+public:
+    Fdn(int blockSize, float sampleRate)
+    {
+        sampleRate_ = sampleRate;
+        for (int i = 0; i < kAmbienceFdnNofLines; i++)
+        {
+            // Room for the interpolation sample.
+            lines_[i] = FdnDelayLine::create(GetMaxDelay(i, sampleRate_) + 2);
+            reads_[i] = FloatArray::create(blockSize);
+            writes_[i] = FloatArray::create(blockSize);
+            lps_[i] = 0;
+        }
+        lpCoeff_ = 1.f - expf(-k2Pi * kAmbienceFdnDampFreq / sampleRate_);
+        time_ = 0;
+        needsUpdate_ = false;
+
+        SetSZ(1);
+        UpdateDelayTimes();
+    }
+    ~Fdn()
+    {
+        for (int i = 0; i < kAmbienceFdnNofLines; i++)
+        {
+            FdnDelayLine::destroy(lines_[i]);
+            FloatArray::destroy(reads_[i]);
+            FloatArray::destroy(writes_[i]);
+        }
+    }
+
+    static Fdn* create(int blockSize, float sampleRate)
+    {
+        return new Fdn(blockSize, sampleRate);
+    }
+
+    static void destroy(Fdn* fdn)
+    {
+        delete fdn;
+    }
+
+    static int GetNofStages()
+    {
+        return kAmbienceFdnNofLines;
+    }
+
+    /**
+     * @brief Worst case delay of a line, with the smallest size.
+     */
+    static float GetMaxDelay(int line, float sampleRate)
+    {
+        return M2D(kAmbienceFdnSizeMin + kAmbienceFdnOffsets[line], sampleRate);
+    }
+
+    // Allocated memory of a line, in bytes.
+    uint32_t GetStageMemory(int line)
+    {
+        return lines_[line]->getSize() * sizeof(float);
+    }
+
+    uint32_t GetMemory()
+    {
+        uint32_t bytes = 0;
+        for (int i = 0; i < kAmbienceFdnNofLines; i++)
+        {
+            bytes += GetStageMemory(i);
+        }
+
+        return bytes;
+    }
+
+    /**
+     * @param size Lower is longer, down to kAmbienceFdnSizeMin
+     */
+    void SetSZ(float size)
+    {
+        size = Max(size, kAmbienceFdnSizeMin);
+        for (int i = 0; i < kAmbienceFdnNofLines; i++)
+        {
+            newDelayTimes_[i] = M2D(size + kAmbienceFdnOffsets[i], sampleRate_);
+        }
+        needsUpdate_ = true;
+    }
+
+    void SetRT(float time)
+    {
+        time_ = time;
+        float rt = M2D(time, sampleRate_);
+        for (int i = 0; i < kAmbienceFdnNofLines; i++)
+        {
+            // Each line decays by its own length, so that all the modes
+            // ring for the same time.
+            float g = Db2A((delayTimes_[i] / rt) * -60.f);
+            if (g >= kOne) {
+                g = 1.f;
+            }
+            // The matrix isn't normalized, scale it here.
+            gains_[i] = g * kRSqrt2 * 0.5f;
+        }
+    }
+
+    /**
+     * @brief No-op: the Hadamard matrix always mixes all the lines fully,
+     *        there's no diffusion amount to set.
+     */
+    void SetDf(float df)
+    {
+    }
+
+    /**
+     * @brief Always 0: the feedback stays inside the network, so there's
+     *        nothing to send back through the Ambience damping.
+     */
+    float GetFbOut(int channel, size_t i)
+    {
+        return 0.f;
+    }
+
+    void UpdateDelayTimes()
+    {
+        if (!needsUpdate_)
+        {
+            return;
+        }
+
+        for (int i = 0; i < kAmbienceFdnNofLines; i++)
+        {
+            delayTimes_[i] = newDelayTimes_[i];
+        }
+        needsUpdate_ = false;
+
+        // The gains depend on the delay times.
+        SetRT(time_);
+    }
+
+    /**
+     * @brief Reads the line outputs for the next block, crossfading from the
+     *        current to the new delay times starting at x.
+     */
+    void PrepareBlock(size_t size, float x, float xi)
+    {
+        for (int i = 0; i < kAmbienceFdnNofLines; i++)
+        {
+            lines_[i]->readBlock(reads_[i].subArray(0, size), delayTimes_[i], newDelayTimes_[i], x, xi);
+        }
+    }
+
+    // Processes in place the block prepared with PrepareBlock().
+    void Process(FloatArray left, FloatArray right)
+    {
+        size_t size = left.getSize();
+        float x[kAmbienceFdnNofLines];
+
+        for (size_t j = 0; j < size; j++)
+        {
+            float l = 0.f;
+            float r = 0.f;
+            for (int i = 0; i < kAmbienceFdnNofLines; i += 2)
+            {
+                x[i] = reads_[i][j];
+                x[i + 1] = reads_[i + 1][j];
+                l += x[i];
+                r += x[i + 1];
+            }
+
+            // Fast Walsh-Hadamard transform.
+            for (int h = 1; h < kAmbienceFdnNofLines; h <<= 1)
+            {
+                for (int i = 0; i < kAmbienceFdnNofLines; i += h << 1)
+                {
+                    for (int k = i; k < i + h; k++)
+                    {
+                        float a = x[k];
+                        float b = x[k + h];
+                        x[k] = a + b;
+                        x[k + h] = a - b;
+                    }
+                }
+            }
+
+            for (int i = 0; i < kAmbienceFdnNofLines; i += 2)
+            {
+                ONE_POLE(lps_[i], x[i] * gains_[i], lpCoeff_);
+                ONE_POLE(lps_[i + 1], x[i + 1] * gains_[i + 1], lpCoeff_);
+                writes_[i][j] = left[j] + lps_[i];
+                writes_[i + 1][j] = right[j] + lps_[i + 1];
+            }
+
+            left[j] = l * 0.5f;
+            right[j] = r * 0.5f;
+        }
+
+        for (int i = 0; i < kAmbienceFdnNofLines; i++)
+        {
+            lines_[i]->writeBlock(writes_[i].subArray(0, size));
+        }
+    }
+
+private:
+    typedef MaskedDelayLine<SATURATE_ON_WRITE> FdnDelayLine;
+
+    FdnDelayLine *lines_[kAmbienceFdnNofLines];
+    FloatArray reads_[kAmbienceFdnNofLines];
+    FloatArray writes_[kAmbienceFdnNofLines];
+    float delayTimes_[kAmbienceFdnNofLines], newDelayTimes_[kAmbienceFdnNofLines];
+    float gains_[kAmbienceFdnNofLines];
+    float lps_[kAmbienceFdnNofLines];
+    float sampleRate_, time_, lpCoeff_;
+    bool needsUpdate_;
+}; // End Fdn
+
+/**
+ * @brief Alternative to Diffuse that convolves each channel with its own
+ *        channel of an impulse response, by uniformly partitioned
+ *        overlap-save FFT convolution. A partition spans several blocks
+ *        and its work is spread across them: the left channel does its
+ *        forward FFT on the first block and its inverse FFT on the one
+ *        before last, the right channel one block later, and the spectral
+ *        products are spread evenly in between. With 4 blocks or more per
+ *        partition no block does more than one transform; with 2 a block
+ *        does two, and with 1 all four. The output is two partitions late.
+ *        The impulse response is read from the PATCH_SETTINGS_NAME ".ir"
+ *        resource, interleaved stereo 32 bit floats at 48kHz. Without it a
+ *        decaying noise burst is used.
+ *        The size shortens the impulse response and the decay fades it out,
+ *        one gain per partition, both applied from the next partition on.
+ *        The diffusion is the one of the impulse response: SetDf(),
+ *        GetFbOut() and PrepareBlock() are no-ops kept for the common
+ *        interface.
+ */
+class Convolver
+{
+public:
+    Convolver(int blockSize, float sampleRate)
+    {
+        sampleRate_ = sampleRate;
+        blockSize_ = blockSize;
+        partitionSize_ = kAmbienceConvPartitionSize / kAmbienceRateDivider;
+        if (partitionSize_ < blockSize_)
+        {
+            partitionSize_ = blockSize_;
+        }
+        // The partition is also a power of two for the FFT.
+        ASSERT(partitionSize_ % blockSize_ == 0, "The block size must divide the convolution partition");
+        fftSize_ = partitionSize_ * 2;
+        nofPhases_ = partitionSize_ / blockSize_;
+        phase_ = 0;
+
+        // Each channel has its own span of phases, so that with 4 phases
+        // or more the transforms of the channels fall in different blocks.
+        int stagger = nofPhases_ > 1 ? 1 : 0;
+        for (int c = 0; c < 2; c++)
+        {
+            fftPhases_[c] = c * stagger;
+            ifftPhases_[c] = nofPhases_ - 1 - (1 - c) * stagger;
+        }
+        fdlIndex_ = 0;
+
+        fft_ = FastFourierTransform::create(fftSize_);
+        fftIn_ = FloatArray::create(fftSize_);
+        fftOut_ = ComplexFloatArray::create(fftSize_);
+
+        FloatArray irs[2];
+        int length = LoadImpulseResponse(irs);
+        nofPartitions_ = (length + partitionSize_ - 1) / partitionSize_;
+        gains_ = FloatArray::create(nofPartitions_);
+        size_ = kAmbienceDiffuseSizeMin;
+        time_ = 0;
+        needsUpdate_ = true;
+        UpdateDelayTimes();
+
+        for (int c = 0; c < 2; c++)
+        {
+            window_[c] = FloatArray::create(fftSize_);
+            window_[c].clear();
+            acc_[c] = FloatArray::create(fftSize_);
+            acc_[c].clear();
+            ins_[c] = FloatArray::create(partitionSize_);
+            outs_[c] = FloatArray::create(partitionSize_);
+            outs_[c].clear();
+            nexts_[c] = FloatArray::create(partitionSize_);
+            nexts_[c].clear();
+            fdl_[c] = FloatArray::create(nofPartitions_ * fftSize_);
+            fdl_[c].clear();
+            h_[c] = FloatArray::create(nofPartitions_ * fftSize_);
+
+            for (int p = 0; p < nofPartitions_; p++)
+            {
+                fftIn_.clear();
+                fftIn_.subArray(0, partitionSize_).copyFrom(irs[c].subArray(p * partitionSize_, partitionSize_));
+                fft_->fft(fftIn_, fftOut_);
+                h_[c].subArray(p * fftSize_, fftSize_).copyFrom(GetSpectrum());
+            }
+            FloatArray::destroy(irs[c]);
+        }
+    }
+    ~Convolver()
+    {
+        for (int c = 0; c < 2; c++)
+        {
+            FloatArray::destroy(window_[c]);
+            FloatArray::destroy(acc_[c]);
+            FloatArray::destroy(ins_[c]);
+            FloatArray::destroy(outs_[c]);
+            FloatArray::destroy(nexts_[c]);
+            FloatArray::destroy(fdl_[c]);
+            FloatArray::destroy(h_[c]);
+        }
+        FastFourierTransform::destroy(fft_);
+        FloatArray::destroy(fftIn_);
+        ComplexFloatArray::destroy(fftOut_);
+        FloatArray::destroy(gains_);
+    }
+
+    static Convolver* create(int blockSize, float sampleRate)
+    {
+        return new Convolver(blockSize, sampleRate);
+    }
+
+    static void destroy(Convolver* convolver)
+    {
+        delete convolver;
+    }
+
+    int GetNofStages()
+    {
+        return nofPartitions_;
+    }
+
+    // Memory of the spectra of a partition for both channels, in bytes.
+    uint32_t GetStageMemory(int partition)
+    {
+        return fftSize_ * 2 * 2 * sizeof(float);
+    }
+
+    uint32_t GetMemory()
+    {
+        return GetStageMemory(0) * nofPartitions_;
+    }
+
+    /**
+     * @param size Lower is longer, down to kAmbienceDiffuseSizeMin for the
+     *        whole impulse response. It scales the length like it scales
+     *        the Diffuse delays.
+     */
+    void SetSZ(float size)
+    {
+        size_ = Max(size, kAmbienceDiffuseSizeMin);
+        needsUpdate_ = true;
+    }
+
+    void SetRT(float time)
+    {
+        time_ = time;
+        needsUpdate_ = true;
+    }
+
+    void SetDf(float df)
+    {
+    }
+
+    // There is no feedback.
+    float GetFbOut(int channel, size_t i)
+    {
+        return 0.f;
+    }
+
+    /**
+     * @brief Applies the size and the decay, once the partition being
+     *        computed is done so that all of it uses the same gains.
+     */
+    void UpdateDelayTimes()
+    {
+        if (!needsUpdate_ || phase_ != 0)
+        {
+            return;
+        }
+        needsUpdate_ = false;
+
+        float length = nofPartitions_ * M2D(size_, sampleRate_) / M2D(kAmbienceDiffuseSizeMin, sampleRate_);
+        activePartitions_ = Clamp((int)ceilf(length), 1, nofPartitions_);
+
+        // Same decay as Diffuse, with the partition start as the delay.
+        float rt = M2D(time_, sampleRate_);
+        for (int p = 0; p < activePartitions_; p++)
+        {
+            float g = Db2A((p * partitionSize_ / rt) * -60.f);
+            gains_[p] = g >= kOne ? 1.f : g;
+            if (g < kAmbienceConvMinGain)
+            {
+                // Inaudible from here on.
+                activePartitions_ = p;
+                break;
+            }
+        }
+    }
+
+    void PrepareBlock(size_t size, float x, float xi)
+    {
+    }
+
+    // Processes a block in place.
+    void Process(FloatArray left, FloatArray right)
+    {
+        size_t size = left.getSize();
+        int offset = phase_ * blockSize_;
+        FloatArray io[2] = { left, right };
+
+        for (int c = 0; c < 2; c++)
+        {
+            ins_[c].subArray(offset, size).copyFrom(io[c]);
+            io[c].copyFrom(outs_[c].subArray(offset, size));
+        }
+
+        for (int c = 0; c < 2; c++)
+        {
+            if (phase_ < fftPhases_[c] || phase_ > ifftPhases_[c])
+            {
+                continue;
+            }
+            if (phase_ == fftPhases_[c])
+            {
+                // The input might be modified by the FFT.
+                fftIn_.copyFrom(window_[c]);
+                fft_->fft(fftIn_, fftOut_);
+                fdl_[c].subArray(fdlIndex_ * fftSize_, fftSize_).copyFrom(GetSpectrum());
+                acc_[c].clear();
+            }
+
+            // This phase's share of the partitions of the channel.
+            int span = ifftPhases_[c] - fftPhases_[c] + 1;
+            int k = phase_ - fftPhases_[c];
+            int first = k * nofPartitions_ / span;
+            int last = (k + 1) * nofPartitions_ / span;
+            if (last > activePartitions_)
+            {
+                last = activePartitions_;
+            }
+            for (int p = first; p < last; p++)
+            {
+                int slot = (fdlIndex_ + nofPartitions_ - p) % nofPartitions_;
+                MultiplyAccumulate(fdl_[c].getData() + slot * fftSize_, h_[c].getData() + p * fftSize_, gains_[p], acc_[c].getData());
+            }
+
+            if (phase_ == ifftPhases_[c])
+            {
+                GetSpectrum().copyFrom(acc_[c]);
+                fft_->ifft(fftOut_, fftIn_);
+                // Only the second half is free of circular aliasing.
+                nexts_[c].copyFrom(fftIn_.subArray(partitionSize_, partitionSize_));
+            }
+        }
+
+        if (phase_ == nofPhases_ - 1)
+        {
+            // The partition is complete, its output starts with the next block.
+            for (int c = 0; c < 2; c++)
+            {
+                window_[c].subArray(0, partitionSize_).copyFrom(window_[c].subArray(partitionSize_, partitionSize_));
+                window_[c].subArray(partitionSize_, partitionSize_).copyFrom(ins_[c]);
+
+                FloatArray t = outs_[c];
+                outs_[c] = nexts_[c];
+                nexts_[c] = t;
+            }
+            fdlIndex_ = (fdlIndex_ + 1) % nofPartitions_;
+        }
+
+        phase_ = (phase_ + 1) % nofPhases_;
+    }
+
+private:
+    FastFourierTransform* fft_;
+    FloatArray fftIn_;
+    ComplexFloatArray fftOut_;
+    // Last two input partitions, the overlap-save window.
+    FloatArray window_[2];
+    // Spectrum of the partition being computed.
+    FloatArray acc_[2];
+    FloatArray ins_[2];
+    FloatArray outs_[2];
+    FloatArray nexts_[2];
+    // Spectra of the last input partitions and of the impulse response.
+    FloatArray fdl_[2];
+    FloatArray h_[2];
+    // Decay of each partition of the impulse response.
+    FloatArray gains_;
+    float sampleRate_, size_, time_;
+    int blockSize_, partitionSize_, fftSize_, nofPhases_, nofPartitions_, activePartitions_;
+    int phase_, fdlIndex_;
+    // Phases of the forward and of the inverse FFT of each channel.
+    int fftPhases_[2], ifftPhases_[2];
+    bool needsUpdate_;
+
+    // The packed real spectrum, fftSize_ floats, at the start of fftOut_.
+    FloatArray GetSpectrum()
+    {
+        return FloatArray((float*)fftOut_.getData(), fftSize_);
+    }
+
+    /**
+     * @brief acc += x * h * gain, bin by bin.
+     *        This depends on the packed layout of arm_rfft_fast_f32, which
+     *        FastFourierTransform uses: x[0] and x[1] are the real DC and
+     *        Nyquist bins, multiplied as reals, then come the interleaved
+     *        real and imaginary parts of bins 1 to N/2 - 1. It must change
+     *        with an FFT that packs its output differently.
+     */
+    void MultiplyAccumulate(const float* x, const float* h, float gain, float* acc)
+    {
+        acc[0] += x[0] * h[0] * gain;
+        acc[1] += x[1] * h[1] * gain;
+        for (int k = 2; k < fftSize_; k += 2)
+        {
+            float re = x[k] * h[k] - x[k + 1] * h[k + 1];
+            float im = x[k] * h[k + 1] + x[k + 1] * h[k];
+            acc[k] += re * gain;
+            acc[k + 1] += im * gain;
+        }
+    }
+
+    /**
+     * @brief Allocates irs and fills them with the impulse response at the
+     *        wet rate, normalized to unit energy.
+     *
+     * @return The length in frames, a multiple of the partition size
+     */
+    int LoadImpulseResponse(FloatArray irs[2])
+    {
+        int length = 0;
+        for (int c = 0; c < 2; c++)
+        {
+            irs[c] = FloatArray::create(kAmbienceConvMaxLength);
+            irs[c].clear();
+        }
+
+        Resource* resource = Resource::load(PATCH_SETTINGS_NAME ".ir");
+        if (resource)
+        {
+            FloatArray data = resource->asArray<FloatArray, float>();
+            length = data.getSize() / 2;
+            if (length > kAmbienceConvMaxLength)
+            {
+                length = kAmbienceConvMaxLength;
+            }
+            for (int i = 0; i < length; i++)
+            {
+                irs[LEFT_CHANNEL][i] = data[i * 2];
+                irs[RIGHT_CHANNEL][i] = data[i * 2 + 1];
+            }
+            Resource::destroy(resource);
+        }
+
+        if (length == 0)
+        {
+            // A decorrelated noise burst, down by 60dB at the end.
+            length = kAmbienceConvMaxLength;
+            float g = 1.f;
+            float k = Db2A(-60.f / length);
+            for (int i = 0; i < length; i++)
+            {
+                irs[LEFT_CHANNEL][i] = RandomFloat(-1.f, 1.f) * g;
+                irs[RIGHT_CHANNEL][i] = RandomFloat(-1.f, 1.f) * g;
+                g *= k;
+            }
+        }
+
+#ifdef USE_AMBIENCE_HALF_RATE
+        length += length & 1;
+        for (int c = 0; c < 2; c++)
+        {
+            HalfbandDecimator* decimator = HalfbandDecimator::create(length);
+            decimator->Process(irs[c].subArray(0, length), irs[c].subArray(0, length / 2));
+            HalfbandDecimator::destroy(decimator);
+            irs[c].subArray(length / 2, length - length / 2).clear();
+        }
+        length /= 2;
+#endif
+
+        float energy = 0;
+        for (int c = 0; c < 2; c++)
+        {
+            for (int i = 0; i < length; i++)
+            {
+                energy += irs[c][i] * irs[c][i];
+            }
+        }
+        if (energy > 0)
+        {
+            // Keep the balance between the channels.
+            float g = 1.f / sqrtf(energy * 0.5f);
+            irs[LEFT_CHANNEL].multiply(g);
+            irs[RIGHT_CHANNEL].multiply(g);
+        }
+
+        return ((length + partitionSize_ - 1) / partitionSize_) * partitionSize_;
+    }
+}; // End Convolver
+
+#ifdef USE_AMBIENCE_CONVOLUTION
+typedef Convolver AmbienceDiffuser;
+#elif defined(USE_AMBIENCE_FDN)
+typedef Fdn AmbienceDiffuser;
+#else
+typedef Diffuse AmbienceDiffuser;
+#endif
+
+// Decay parameter to reverb time, built at compile time.
+constexpr Lut<float, 32> kAmbienceDecayLut(0.f, -160.f, Lut<float, 32>::LUT_TYPE_EXPO);
+
 class ReversedBuffer
 {
 public:
@@ -302,18 +1037,28 @@ private:
     SineOscillator *panner_;
 
     Damp *dampFilters_[2];
-    Diffuse *diffusers_[2];
+    AmbienceDiffuser *diffuser_;
     ReversedBuffer *reversers_[2];
 
-    EnvFollower* ef_[2];
+    EnvFollowerBank<2> ef_;
     Compressor* comp_[2];
     DcBlockingFilter* dc_[2];
+    EqualPowerCrossFader crossFader_{1.4f};
+
+    // Clamped input, also the dry signal.
+    FloatArray dry_[2];
+    FloatArray wet_[2];
+#ifdef USE_AMBIENCE_HALF_RATE
+    HalfbandDecimator* decimators_[2];
+    HalfbandInterpolator* interpolators_[2];
+    FloatArray ins_[2];
+    FloatArray ups_[2];
+#endif
 
     float amp_, pan_, decay_, spaceTime_;
     float reverse_;
     float xi_;
-
-    Lut<float, 32> decayLUT{0.f, -160.f, Lut<float, 32>::Type::LUT_TYPE_EXPO};
+    ChangeTracker decayChange_, spacetimeChange_;
 
     /**
      * @param damp Attenuation in Db
@@ -335,19 +1080,16 @@ private:
 
     void SetDecayTime(float time)
     {
-        diffusers_[LEFT_CHANNEL]->SetRT(time);
-        diffusers_[RIGHT_CHANNEL]->SetRT(time);
+        diffuser_->SetRT(time);
     }
 
     void SetSize(float size)
     {
         float sz = -(size - 30.f);
-        diffusers_[LEFT_CHANNEL]->SetSZ(sz);
-        diffusers_[RIGHT_CHANNEL]->SetSZ(sz);
+        diffuser_->SetSZ(sz);
 
         float df = (size * 0.004166667f) + 0.5f; // 1 / 240
-        diffusers_[LEFT_CHANNEL]->SetDf(df);
-        diffusers_[RIGHT_CHANNEL]->SetDf(df);
+        diffuser_->SetDf(df);
     }
 
     void SetPan(float value)
@@ -361,12 +1103,12 @@ private:
     void SetDecay(float value)
     {
         decay_ = value;
-        SetDecayTime(decayLUT.Quantized(decay_));
+        SetDecayTime(kAmbienceDecayLut.Lookup(decay_));
     }
 
     void SetSpacetime(float value)
     {
-        spaceTime_ = CenterMap(value, -1.f, 1.f, 0.48f);
+        spaceTime_ = CenterRange(-1.f, 1.f, 0.48f).Map(value);
 
         float lowDamp = kAmbienceLowDampMin;
         float highDamp = kAmbienceHighDampMin;
@@ -377,25 +1119,25 @@ private:
         if (spaceTime_ < 0.f) {
             if (spaceTime_ < -0.4f)
             {
-                highDamp = Map(spaceTime_, -1.f, -0.4f, kAmbienceHighDampMax, kAmbienceHighDampMin);
+                highDamp = Range(-1.f, -0.4f, kAmbienceHighDampMax, kAmbienceHighDampMin).Map(spaceTime_);
             }
             else
             {
-                lowDamp = Map(spaceTime_, -0.4f, 0.f, kAmbienceLowDampMin, kAmbienceLowDampMax);
+                lowDamp = Range(-0.4f, 0.f, kAmbienceLowDampMin, kAmbienceLowDampMax).Map(spaceTime_);
             }
-            size = 60.1f - MapExpo(spaceTime_, -1.f, 0.f, 0.1f, 60.f);
-            amp_ = a <= 0.5f ? MapLog(a, 0.f, 0.5f, 3.f, 0.6f) : MapExpo(a, 0.51f, 1.f, 0.6f, Map(decay_, 0.f, 1.f, 1.4f, 1.2f));
+            size = 60.1f - ExpoRange(-1.f, 0.f, 0.1f, 60.f).Map(spaceTime_);
+            amp_ = a <= 0.5f ? LogRange(0.f, 0.5f, 3.f, 0.6f).Map(a) : ExpoRange(0.51f, 1.f, 0.6f, Range(0.f, 1.f, 1.4f, 1.2f).Map(decay_)).Map(a);
         } else {
             if (spaceTime_ < 0.4f)
             {
-                lowDamp = Map(spaceTime_, 0.f, 0.4f, kAmbienceLowDampMax, kAmbienceLowDampMin);
+                lowDamp = Range(0.f, 0.4f, kAmbienceLowDampMax, kAmbienceLowDampMin).Map(spaceTime_);
             }
             else
             {
-                highDamp = Map(spaceTime_, 0.4f, 1.f, kAmbienceHighDampMin, kAmbienceHighDampMax);
+                highDamp = Range(0.4f, 1.f, kAmbienceHighDampMin, kAmbienceHighDampMax).Map(spaceTime_);
             }
-            size = MapExpo(spaceTime_, 0.f, 1.f, 0.1f, 60.f);
-            amp_ = a <= 0.3f ? MapLog(a, 0.f, 0.3f, 3.f, 0.6f) : MapExpo(a, 0.31f, 1.f, 0.6f, 1.f);
+            size = ExpoRange(0.f, 1.f, 0.1f, 60.f).Map(spaceTime_);
+            amp_ = a <= 0.3f ? LogRange(0.f, 0.3f, 3.f, 0.6f).Map(a) : ExpoRange(0.31f, 1.f, 0.6f, 1.f).Map(a);
         }
 
         SetLowDamp(lowDamp);
@@ -412,7 +1154,7 @@ private:
         }
         else
         {
-            reverse_ = Map(spaceTime_, -0.2f, 0.2f, 1.f, 0.f);
+            reverse_ = Range(-0.2f, 0.2f, 1.f, 0.f).Map(spaceTime_);
         }
     }
 
@@ -423,14 +1165,27 @@ public:
         patchCvs_ = patchCvs;
         patchState_ = patchState;
 
+        // The wet path runs at a fraction of the sample rate.
+        int wetSize = patchState_->blockSize / kAmbienceRateDivider;
+        float wetRate = patchState_->sampleRate / kAmbienceRateDivider;
+        // Same time constant of the one pole filters at the wet rate.
+        float lambda = powf(0.995f, kAmbienceRateDivider);
+        ef_.setLambda(lambda);
+
         for (size_t i = 0; i < 2; i++)
         {
-            dampFilters_[i] = Damp::create(patchState_->sampleRate);
-            diffusers_[i] = Diffuse::create();
-            reversers_[i] = ReversedBuffer::create(kAmbienceBufferSize);
-            ef_[i] = EnvFollower::create();
-            dc_[i] = DcBlockingFilter::create();
-            comp_[i] = Compressor::create(patchState_->sampleRate);
+            dampFilters_[i] = Damp::create(wetRate);
+            dry_[i] = FloatArray::create(patchState_->blockSize);
+            wet_[i] = FloatArray::create(wetSize);
+#ifdef USE_AMBIENCE_HALF_RATE
+            decimators_[i] = HalfbandDecimator::create(patchState_->blockSize);
+            interpolators_[i] = HalfbandInterpolator::create(patchState_->blockSize);
+            ins_[i] = FloatArray::create(wetSize);
+            ups_[i] = FloatArray::create(patchState_->blockSize);
+#endif
+            reversers_[i] = ReversedBuffer::create(kAmbienceBufferSize / kAmbienceRateDivider);
+            dc_[i] = DcBlockingFilter::create(lambda);
+            comp_[i] = Compressor::create(wetRate);
             comp_[i]->setAttack(100);
             comp_[i]->setAttack(100);
             comp_[i]->setThreshold(-30);
@@ -443,23 +1198,31 @@ public:
         dampFilters_[RIGHT_CHANNEL]->SetHp(96);
         dampFilters_[RIGHT_CHANNEL]->SetLp(51);
 
+        diffuser_ = AmbienceDiffuser::create(wetSize, wetRate);
         panner_ = SineOscillator::create(patchState_->blockRate);
 
         amp_ = 1.f;
         pan_ = 0.5f;
-        xi_ = 1.f / patchState_->blockSize;
+        xi_ = 1.f / wetSize;
     }
     ~Ambience()
     {
         for (size_t i = 0; i < 2; i++)
         {
             Damp::destroy(dampFilters_[i]);
-            Diffuse::destroy(diffusers_[i]);
+            FloatArray::destroy(dry_[i]);
+            FloatArray::destroy(wet_[i]);
+#ifdef USE_AMBIENCE_HALF_RATE
+            HalfbandDecimator::destroy(decimators_[i]);
+            HalfbandInterpolator::destroy(interpolators_[i]);
+            FloatArray::destroy(ins_[i]);
+            FloatArray::destroy(ups_[i]);
+#endif
             ReversedBuffer::destroy(reversers_[i]);
-            EnvFollower::destroy(ef_[i]);
             DcBlockingFilter::destroy(dc_[i]);
             Compressor::destroy(comp_[i]);
         }
+        AmbienceDiffuser::destroy(diffuser_);
         SineOscillator::destroy(panner_);
     }
 
@@ -473,6 +1236,17 @@ public:
         delete obj;
     }
 
+    // Memory of a diffuser stage, or FDN line, in bytes.
+    uint32_t GetDiffuserMemory(int stage)
+    {
+        return diffuser_->GetStageMemory(stage);
+    }
+
+    uint32_t GetDiffusersMemory()
+    {
+        return diffuser_->GetMemory();
+    }
+
     void process(AudioBuffer &input, AudioBuffer &output)
     {
         size_t size = output.getSize();
@@ -484,18 +1258,45 @@ public:
         SetPan(patchCtrls_->ambienceAutoPan);
 
         float d = Modulate(patchCtrls_->ambienceDecay, patchCtrls_->ambienceDecayModAmount, patchState_->modValue, patchCtrls_->ambienceDecayCvAmount, patchCvs_->ambienceDecay, -1.f, 1.f, patchState_->modAttenuverters, patchState_->cvAttenuverters);
-        SetDecay(d);
+        bool decayChanged = decayChange_.Changed(d);
+        if (decayChanged)
+        {
+            SetDecay(d);
+        }
 
         float t = Modulate(patchCtrls_->ambienceSpacetime, patchCtrls_->ambienceSpacetimeModAmount, patchState_->modValue, patchCtrls_->ambienceSpacetimeCvAmount, patchCvs_->ambienceSpacetime, -1.f, 1.f, patchState_->modAttenuverters, patchState_->cvAttenuverters);
-        SetSpacetime(t);
+        // The gain depends on the decay too.
+        if (spacetimeChange_.Changed(t) || decayChanged)
+        {
+            SetSpacetime(spacetimeChange_.Get());
+        }
 
         float r = 1.f - reverse_;
-        float x = 0;
 
         for (size_t i = 0; i < size; i++)
         {
-            float lIn = Clamp(leftIn[i], -3.f, 3.f);
-            float rIn = Clamp(rightIn[i], -3.f, 3.f);
+            dry_[LEFT_CHANNEL][i] = Clamp(leftIn[i], -3.f, 3.f);
+            dry_[RIGHT_CHANNEL][i] = Clamp(rightIn[i], -3.f, 3.f);
+        }
+
+#ifdef USE_AMBIENCE_HALF_RATE
+        size_t wetSize = size / kAmbienceRateDivider;
+        decimators_[LEFT_CHANNEL]->Process(dry_[LEFT_CHANNEL].subArray(0, size), ins_[LEFT_CHANNEL].subArray(0, wetSize));
+        decimators_[RIGHT_CHANNEL]->Process(dry_[RIGHT_CHANNEL].subArray(0, size), ins_[RIGHT_CHANNEL].subArray(0, wetSize));
+        FloatArray* ins = ins_;
+        FloatArray* wets = ups_;
+#else
+        size_t wetSize = size;
+        FloatArray* ins = dry_;
+        FloatArray* wets = wet_;
+#endif
+
+        diffuser_->PrepareBlock(wetSize, 0.f, xi_);
+
+        for (size_t i = 0; i < wetSize; i++)
+        {
+            float lIn = ins[LEFT_CHANNEL][i];
+            float rIn = ins[RIGHT_CHANNEL][i];
 
             float left = reversers_[LEFT_CHANNEL]->LastOut() * reverse_ + lIn * r;
             float right = reversers_[RIGHT_CHANNEL]->LastOut() * reverse_ + rIn * r;
@@ -503,33 +1304,41 @@ public:
             reversers_[LEFT_CHANNEL]->Process(lIn);
             reversers_[RIGHT_CHANNEL]->Process(rIn);
 
-            float leftFb = dampFilters_[LEFT_CHANNEL]->Process(left + diffusers_[RIGHT_CHANNEL]->GetFbOut());
-            float rightFb = dampFilters_[RIGHT_CHANNEL]->Process(right + diffusers_[LEFT_CHANNEL]->GetFbOut());
+            float leftFb = dampFilters_[LEFT_CHANNEL]->Process(left + diffuser_->GetFbOut(RIGHT_CHANNEL, i));
+            float rightFb = dampFilters_[RIGHT_CHANNEL]->Process(right + diffuser_->GetFbOut(LEFT_CHANNEL, i));
 
             leftFb = HardClip(left * (1.f - pan_) + leftFb);
             rightFb = HardClip(right * pan_ + rightFb);
 
-            leftFb *= 1.f - ef_[LEFT_CHANNEL]->process(leftFb);
-            rightFb *= 1.f - ef_[RIGHT_CHANNEL]->process(rightFb);
+            float fbs[2] = { leftFb, rightFb };
+            float envs[2];
+            ef_.process(fbs, envs);
+            leftFb *= 1.f - envs[LEFT_CHANNEL];
+            rightFb *= 1.f - envs[RIGHT_CHANNEL];
 
-            leftFb = dc_[LEFT_CHANNEL]->process(leftFb);
-            rightFb = dc_[RIGHT_CHANNEL]->process(rightFb);
-
-            left = diffusers_[LEFT_CHANNEL]->Process(leftFb, x);
-            right = diffusers_[RIGHT_CHANNEL]->Process(rightFb, x);
+            wet_[LEFT_CHANNEL][i] = dc_[LEFT_CHANNEL]->process(leftFb);
+            wet_[RIGHT_CHANNEL][i] = dc_[RIGHT_CHANNEL]->process(rightFb);
+        }
 
-            x += xi_;
+        diffuser_->Process(wet_[LEFT_CHANNEL].subArray(0, wetSize), wet_[RIGHT_CHANNEL].subArray(0, wetSize));
 
-            float a = Map(decay_, 0.f, 1.f, amp_ * 1.3f, amp_);
+        constexpr Range decayAmpRange(0.f, 1.f, 1.3f, 1.f);
+        float a = amp_ * decayAmpRange.Map(decay_);
+        for (size_t i = 0; i < wetSize; i++)
+        {
+            wet_[LEFT_CHANNEL][i] = comp_[LEFT_CHANNEL]->process(wet_[LEFT_CHANNEL][i] * a) * kAmbienceMakeupGain;
+            wet_[RIGHT_CHANNEL][i] = comp_[RIGHT_CHANNEL]->process(wet_[RIGHT_CHANNEL][i] * a) * kAmbienceMakeupGain;
+        }
 
-            left = comp_[LEFT_CHANNEL]->process(left * a) * kAmbienceMakeupGain;
-            right = comp_[RIGHT_CHANNEL]->process(right * a) * kAmbienceMakeupGain;
+#ifdef USE_AMBIENCE_HALF_RATE
+        interpolators_[LEFT_CHANNEL]->Process(wet_[LEFT_CHANNEL].subArray(0, wetSize), ups_[LEFT_CHANNEL].subArray(0, size));
+        interpolators_[RIGHT_CHANNEL]->Process(wet_[RIGHT_CHANNEL].subArray(0, wetSize), ups_[RIGHT_CHANNEL].subArray(0, size));
+#endif
 
-            leftOut[i] = CheapEqualPowerCrossFade(lIn, left, patchCtrls_->ambienceVol, 1.4f);
-            rightOut[i] = CheapEqualPowerCrossFade(rIn, right, patchCtrls_->ambienceVol, 1.4f);
-        }
+        crossFader_.SetPos(patchCtrls_->ambienceVol);
+        crossFader_.Process(dry_[LEFT_CHANNEL].subArray(0, size), wets[LEFT_CHANNEL].subArray(0, size), leftOut);
+        crossFader_.Process(dry_[RIGHT_CHANNEL].subArray(0, size), wets[RIGHT_CHANNEL].subArray(0, size), rightOut);
 
-        diffusers_[LEFT_CHANNEL]->UpdateDelayTimes();
-        diffusers_[RIGHT_CHANNEL]->UpdateDelayTimes();
+        diffuser_->UpdateDelayTimes();
     }
 };
\ No newline at end of file
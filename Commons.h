@@ -3,11 +3,17 @@
 #include "Patch.h"
 #include "ParameterInterpolator.h"
 #include "TapTempo.h"
+#include "FastMath.h"
 #include <stdlib.h>
 #include <stdint.h>
 #include <cmath>
 
 //#define USE_RECORD_THRESHOLD
+//#define USE_PROFILER // Per-stage cycle counts, see Profiler.h
+//#define USE_ECHO_INT16 // Keep the Echo history as 16 bit, halving its memory
+//#define USE_AMBIENCE_HALF_RATE // Run the Ambience wet path at half the sample rate, see Halfband.h
+//#define USE_AMBIENCE_FDN // Cheaper feedback delay network instead of the Ambience Diffuse chain
+//#define USE_AMBIENCE_CONVOLUTION // Convolution with the impulse response in iroi.ir instead of the Ambience Diffuse chain
 #define MAX_PATCH_SETTINGS 16 // Max number of available MIDI channels
 #define PATCH_SETTINGS_NAME "iroi"
 #define PATCH_VERSION_MAJOR 1
@@ -56,6 +62,8 @@ constexpr float kCvMult = 1.485f;
 constexpr float kCvDelta = 0.02f;
 constexpr float kCvMinThreshold = 0.007f;
 
+constexpr float kChangeThreshold = 0.00025f; // About one step of a 12 bit control
+
 constexpr int kStartupWaitSamples = 450; // 300ms (1500 = 1s @ block rate)
 
 constexpr int kRandomSlewSamples = 128;
@@ -95,13 +103,25 @@ constexpr float kFilterBpGainMin = 0.2f;
 constexpr float kFilterBpGainMax = 0.4f;
 constexpr float kFilterCombGainMin = 0.1f;
 constexpr float kFilterCombGainMax = 0.2f;
+constexpr int kFilterControlRate = 8; // Samples between exact coefficient updates, 1 for full quality
 
 constexpr float kResoGainMin = 0.5f;
 constexpr float kResoGainMax = 1.2f;
 constexpr float kResoMakeupGain = 1.f;
-constexpr int32_t kResoBufferSize = 2400;
+constexpr int32_t kResoBufferSize = 2400; // Longest pole delay
+constexpr int32_t kResoLineSize = kResoBufferSize + 2; // The longest delay and the next sample, for the interpolation
 constexpr float kResoInfiniteFeedbackThreshold = 0.99f;
 constexpr float kResoInfiniteFeedbackLevel = 1.05f;
+constexpr float kResoDcLambda = 0.995f;
+constexpr float kResoEfLambda = 0.995f;
+constexpr float kResoTableMinNote = -24.f;
+constexpr float kResoTableMaxNote = 48.f;
+constexpr int kResoTableSize = kResoTableMaxNote - kResoTableMinNote + 1; // One entry per note
+constexpr int kResoTableStepsPerNote = 256; // Resolution of the fractional note ratios
+constexpr int kResoTableFracSize = kResoTableStepsPerNote + 1;
+constexpr float kResoTableMaxFreq = 12000.f;
+constexpr float kResoTableFreqStep = 25.f;
+constexpr int kResoTableFreqSize = kResoTableMaxFreq / kResoTableFreqStep + 1;
 
 constexpr int32_t kEchoFadeSamples = 2400; // 50 ms @ audio rate
 constexpr int32_t kEchoMinLengthSamples = 480; // 10 ms @ audio rate
@@ -119,6 +139,15 @@ constexpr float kEchoMakeupGain = 1.8f;
 
 constexpr int32_t kAmbienceBufferSize = 48000;
 constexpr int kAmbienceNofDiffusers = 7;
+constexpr float kAmbienceDiffuseSizeMin = -32.38f; // Smallest Diffuse size, with the spacetime fully up (CenterMap overshoots to a 62.37 size)
+constexpr int kAmbienceFdnNofLines = 8;
+constexpr float kAmbienceFdnSizeMin = -30.f; // Smallest Fdn size, at full spacetime without the CenterMap overshoot
+// Pitch offsets of the FDN lines from the size, in semitones.
+constexpr float kAmbienceFdnOffsets[kAmbienceFdnNofLines] = { 0.5f, 1.8f, 3.1f, 4.4f, 5.9f, 7.1f, 8.5f, 9.8f };
+constexpr float kAmbienceFdnDampFreq = 6000.f; // Cutoff of the lowpass in each FDN line
+constexpr int kAmbienceConvPartitionSize = 256; // At 48kHz, also the latency of the convolution
+constexpr int kAmbienceConvMaxLength = 16384; // Longest impulse response in frames at 48kHz
+constexpr float kAmbienceConvMinGain = 0.0001f; // -80dB, impulse response partitions quieter than this are skipped
 constexpr float kAmbienceLowDampMin = -0.5f;
 constexpr float kAmbienceLowDampMax = -40.f;
 constexpr float kAmbienceHighDampMin = -0.5f;
@@ -222,6 +251,8 @@ enum ClockSource
     CLOCK_SOURCE_EXTERNAL,
 };
 
+class Profiler;
+
 struct PatchState
 {
     float sampleRate;
@@ -260,6 +291,10 @@ struct PatchState
     FuncMode funcMode;
 
     bool inputConnected;
+
+    int filterControlRate;
+
+    Profiler* profiler;
 };
 
 inline bool AreEquals(float val1, float val2, float d = kEps)
@@ -327,18 +362,18 @@ float Power(float f, float n = 2, bool approx = false)
 {
     if (approx)
     {
-        long *lp, l;
-        lp = (long *)(&f);
-        l  = *lp;
+        // The bits must be handled as 32 bit, long is 64 bit on some hosts.
+        int32_t l;
+        memcpy(&l, &f, sizeof(l));
         l -= 0x3F800000;
         l <<= ((int) n - 1);
         l += 0x3F800000;
-        *lp = l;
+        memcpy(&f, &l, sizeof(f));
 
         return f;
     }
 
-    return pow(f, n);
+    return powf(f, n);
 }
 
 /**
@@ -361,7 +396,7 @@ inline float F2S(float freq, float sampleRate = 48000.f)
  */
 inline float M2F(float m)
 {
-    return Power(2.f, (m - kA4Note) / kSemi4Oct) * kA4Freq;
+    return FastExp2((m - kA4Note) / kSemi4Oct) * kA4Freq;
 }
 
 /**
@@ -410,45 +445,88 @@ inline float RandomFloat(float min = 0.f, float max = kOne)
 }
 
 /**
- * @brief Maps the value that ranges from aMin to aMax to a value that
- *        ranges from bMin to bMax. Supports inverted ranges.
+ * @brief Maps values that range from aMin to aMax to values that range
+ *        from bMin to bMax. Slope and offset are computed on construction,
+ *        so that mapping a value is a single multiply-add. Supports
+ *        inverted ranges.
  */
-inline float Map(float value, float aMin, float aMax, float bMin, float bMax)
+class Range
 {
-    float k = abs(bMax - bMin) / abs(aMax - aMin) * (bMax > bMin ? 1 : -1);
+private:
+    float k_;
+    float o_;
 
-    return bMin + k * (value - aMin);
-}
+public:
+    constexpr Range() : k_{1.f}, o_{0.f} {}
+    constexpr Range(float aMin, float aMax, float bMin, float bMax) : k_{(bMax - bMin) / (aMax - aMin)}, o_{bMin - aMin * ((bMax - bMin) / (aMax - aMin))} {}
 
-inline float MapExpo(float value, float aMin = 0.f, float aMax = 0.97f, float bMin = 0.f, float bMax = 1.f)
+    constexpr float Map(float value) const
+    {
+        return value * k_ + o_;
+    }
+};
+
+/**
+ * @brief Like Range, with a quadratic curve: slow at the start of the
+ *        output range and fast at its end.
+ */
+class ExpoRange
 {
-    value = (value - aMin) / (aMax - aMin);
+private:
+    Range normal_;
+    float bMin_, d_;
 
-    return bMin + (value * value) * (bMax - bMin);
-}
+public:
+    constexpr ExpoRange(float aMin = 0.f, float aMax = 0.97f, float bMin = 0.f, float bMax = 1.f) : normal_{aMin, aMax, 0.f, 1.f}, bMin_{bMin}, d_{bMax - bMin} {}
 
-inline float MapLog(float value, float aMin = 0.f, float aMax = 1.f, float bMin = 0.f, float bMax = 1.f)
-{
-    bMin = fast_logf(bMin < 0.0000001f ? 0.0000001f : bMin);
-    bMax = fast_logf(bMax);
+    float Map(float value) const
+    {
+        float v = normal_.Map(value);
 
-    return fast_expf(Map(value, aMin, aMax, bMin, bMax));
-}
+        return bMin_ + (v * v) * d_;
+    }
+};
 
-// Maps the value to a range by considering where the original center actually is.
-inline float CenterMap(float value, float min = -1.f, float max = 1.f, float center = 0.55f)
+/**
+ * @brief Like Range, with a logarithmic curve: equal steps of the input
+ *        give equal ratios of the output. The output range must be
+ *        positive. Not constexpr, the logs are taken on construction.
+ */
+class LogRange
 {
-    if (value < center)
+private:
+    Range log_;
+
+public:
+    LogRange(float aMin = 0.f, float aMax = 1.f, float bMin = 0.f, float bMax = 1.f)
     {
-        value = Map(value, 0.0f, center, min, 0.0f);
+        log_ = Range(aMin, aMax, FastLog2(bMin < 0.0000001f ? 0.0000001f : bMin), FastLog2(bMax));
     }
-    else
+
+    float Map(float value) const
     {
-        value = Map(value, center, 0.99f, 0.0f, max);
+        return FastExp2(log_.Map(value));
     }
+};
 
-    return value;
-}
+/**
+ * @brief Maps from 0 - 0.99 to min - max, considering where the center of
+ *        the input range actually is.
+ */
+class CenterRange
+{
+private:
+    Range low_, high_;
+    float center_;
+
+public:
+    constexpr CenterRange(float min = -1.f, float max = 1.f, float center = 0.55f) : low_{0.f, center, min, 0.f}, high_{center, 0.99f, 0.f, max}, center_{center} {}
+
+    float Map(float value) const
+    {
+        return value < center_ ? low_.Map(value) : high_.Map(value);
+    }
+};
 
 /**
  * @brief Returns -1 for negative numbers and +1 for positive numbers.
@@ -485,6 +563,23 @@ inline int QuantizeInt(float value, int32_t steps)
     return rintf(Clamp(value, 0, 1) * (steps - 1));
 }
 
+/**
+ * @brief Rounds a size up to the next power of two.
+ *
+ * @param size
+ * @return uint32_t
+ */
+inline uint32_t NextPowerOfTwo(uint32_t size)
+{
+    uint32_t p = 1;
+    while (p < size)
+    {
+        p <<= 1;
+    }
+
+    return p;
+}
+
 // (a + b) * 1 / sqrt(2)
 inline float Mix2(float a, float b)
 {
@@ -517,7 +612,7 @@ inline float Mix4(float a, float b, float c, float d)
 
 inline float Db2A(float db)
 {
-    return Power(10.f, db / 20.f);
+    return FastDb2A(db);
 }
 
 inline float LinearCrossFade(float a, float b, float pos)
@@ -601,6 +696,96 @@ void CheapEqualPowerCrossFade(AudioBuffer &from, AudioBuffer &to, float pos, Aud
     out.add(to);
 }
 
+/**
+ * @brief Block version of CheapEqualPowerCrossFade. The gains are computed
+ *        once per block by SetPos() and ramped linearly from those of the
+ *        previous block across the block, so that moving the position
+ *        doesn't zipper.
+ */
+class EqualPowerCrossFader
+{
+private:
+    float k_;
+    float pos_;
+    float fromGain_, toGain_;
+    float fromStart_, toStart_;
+    bool started_;
+
+public:
+    EqualPowerCrossFader(float p = kEqualCrossFadeP)
+    {
+        k_ = -6.0026608f + p * (6.8773512f - 1.5838104f * p);
+        pos_ = 0;
+        fromGain_ = fromStart_ = 1.f;
+        toGain_ = toStart_ = 0.f;
+        started_ = false;
+    }
+    ~EqualPowerCrossFader() {}
+
+    /**
+     * @brief Sets the position for the next block, the first one is
+     *        reached without ramping.
+     */
+    void SetPos(float pos)
+    {
+        fromStart_ = fromGain_;
+        toStart_ = toGain_;
+        if (started_ && pos == pos_)
+        {
+            return;
+        }
+
+        pos_ = pos;
+        float invPos = 1.f - pos;
+        float a = pos * invPos;
+        float b = a * (1.f + k_ * a);
+        float c = (b + pos);
+        float d = (b + invPos);
+        fromGain_ = d * d;
+        toGain_ = c * c;
+
+        if (!started_)
+        {
+            fromStart_ = fromGain_;
+            toStart_ = toGain_;
+            started_ = true;
+        }
+    }
+
+    /**
+     * @brief Crossfades a channel of the block, out may be either of the
+     *        inputs. Call it for every channel after SetPos().
+     */
+    void Process(FloatArray from, FloatArray to, FloatArray out)
+    {
+        size_t size = out.getSize();
+        const float* f = from.getData();
+        const float* t = to.getData();
+        float* o = out.getData();
+
+        if (fromStart_ == fromGain_ && toStart_ == toGain_)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                o[i] = f[i] * fromGain_ + t[i] * toGain_;
+            }
+
+            return;
+        }
+
+        float fromInc = (fromGain_ - fromStart_) / size;
+        float toInc = (toGain_ - toStart_) / size;
+        float fromGain = fromStart_;
+        float toGain = toStart_;
+        for (size_t i = 0; i < size; i++)
+        {
+            fromGain += fromInc;
+            toGain += toInc;
+            o[i] = f[i] * fromGain + t[i] * toGain;
+        }
+    }
+};
+
 
 inline void LR2MS(const float left, const float right, float &mid, float &side, float width = 1.f)
 {
@@ -677,6 +862,57 @@ float AudioClip(float x, float s = 1.f)
     return SoftClip(x * s);
 }
 
+/**
+ * @brief Remembers the value that a derived state was last computed from, so
+ *        that the computation can be skipped until the value moves by more
+ *        than the threshold.
+ */
+class ChangeTracker
+{
+private:
+    float value_;
+    float threshold_;
+    bool dirty_;
+
+public:
+    ChangeTracker(float threshold = kChangeThreshold)
+    {
+        value_ = 0;
+        threshold_ = threshold;
+        dirty_ = true;
+    }
+    ~ChangeTracker() {}
+
+    // The next call to Changed() will accept any value.
+    void Invalidate()
+    {
+        dirty_ = true;
+    }
+
+    /**
+     * @brief Accepts the value if it moved beyond the threshold since the
+     *        last accepted one.
+     *
+     * @return true if the value has been accepted
+     */
+    bool Changed(float value)
+    {
+        if (!dirty_ && fabsf(value - value_) <= threshold_)
+        {
+            return false;
+        }
+        value_ = value;
+        dirty_ = false;
+
+        return true;
+    }
+
+    float Get()
+    {
+        return value_;
+    }
+};
+
 // Taken and adapted from stmlib
 class HysteresisQuantizer
 {
@@ -742,6 +978,11 @@ private:
     int quantized_value_;
 };
 
+/**
+ * @brief Lookup table of size values over the positions 0 - 1. The table
+ *        is generated by a constexpr constructor, so a constexpr Lut costs
+ *        nothing at runtime.
+ */
 template<typename T, int size>
 class Lut
 {
@@ -750,65 +991,98 @@ public:
     {
         LUT_TYPE_EXPO,
         LUT_TYPE_LINEAR,
+        LUT_TYPE_LOG,
     };
 
 private:
     T lut_[size];
-    T min_;
-    T max_;
-    Type type_;
-    float expoY_ = 3;
-    HysteresisQuantizer quantizer_;
 
-    void Linear()
+    // Integer power, for the expo curve.
+    static constexpr float Expo(float x, int exponent)
     {
-        float d = (1.f / (size - 1));
-        for (size_t i = 0; i < size; i++)
+        float y = 1.f;
+        for (int i = 0; i < exponent; i++)
         {
-            float x = d * i;
-            lut_[i] = min_ + (max_ - min_) * x;
+            y *= x;
         }
-    }
 
-    void Expo()
-    {
-        float d = (1.f / (size - 1));
-        for (size_t i = 0; i < size; i++)
-        {
-            float x = d * i;
-            lut_[i] = min_ + (max_ - min_) * (x == 1 ? 1 : fast_powf(x, expoY_));
-        }
+        return y;
     }
 
 public:
-    Lut(T min, T max, Type type = LUT_TYPE_LINEAR) : min_{min}, max_{max}, type_{type}
+    /**
+     * @param min Value at position 0, must be positive for LUT_TYPE_LOG
+     * @param max Value at position 1, must be positive for LUT_TYPE_LOG
+     * @param exponent Of the LUT_TYPE_EXPO curve
+     */
+    constexpr Lut(T min, T max, Type type = LUT_TYPE_LINEAR, int exponent = 3) : lut_{}
     {
-        quantizer_.Init(size, 0.15f, false);
+        float logMin = LUT_TYPE_LOG == type ? ConstLog2(min) : 0.f;
+        float logMax = LUT_TYPE_LOG == type ? ConstLog2(max) : 0.f;
 
-        if (LUT_TYPE_EXPO == type)
+        for (int i = 0; i < size; i++)
         {
-            Expo();
+            float x = float(i) / (size - 1);
+            if (LUT_TYPE_LOG == type)
+            {
+                // Equal ratios between the steps.
+                lut_[i] = ConstExp2(logMin + (logMax - logMin) * x);
+            }
+            else
+            {
+                if (LUT_TYPE_EXPO == type)
+                {
+                    x = Expo(x, exponent);
+                }
+                lut_[i] = min + (max - min) * x;
+            }
         }
-        else if (LUT_TYPE_LINEAR == type)
+    }
+
+    /**
+     * @brief Custom table, generator(x) gives the value at position x. It
+     *        must be constexpr for the table to be.
+     */
+    template<typename Generator>
+    constexpr Lut(Generator generator) : lut_{}
+    {
+        for (int i = 0; i < size; i++)
         {
-            Linear();
+            lut_[i] = generator(float(i) / (size - 1));
         }
     }
-    ~Lut() {}
 
-    void SetExpo(float y)
+    constexpr T GetValue(int pos) const
     {
-        expoY_ = y;
+        return lut_[pos];
     }
 
-    T GetValue(int pos)
+    /**
+     * @brief Value at the position, interpolated between the two nearest
+     *        entries.
+     *
+     * @param pos 0 - 1, clamped
+     */
+    T Lookup(float pos) const
     {
-        return lut_[pos];
+        float x = Clamp(pos) * (size - 1);
+        int i = static_cast<int>(x);
+        if (i >= size - 1)
+        {
+            return lut_[size - 1];
+        }
+        float f = x - i;
+
+        return lut_[i] + (lut_[i + 1] - lut_[i]) * f;
     }
 
-    T Quantized(float pos)
+    /**
+     * @brief Nearest value, with hysteresis. The quantizer keeps the state,
+     *        it must have been initialized with size steps.
+     */
+    T Quantized(float pos, HysteresisQuantizer& quantizer) const
     {
-        return quantizer_.Lookup(lut_, pos);
+        return quantizer.Lookup(lut_, pos);
     }
 };
 
@@ -824,9 +1098,11 @@ float Modulate(
     bool modAttenuverters = false,
     bool cvAttenuverters = false
 ) {
+    constexpr CenterRange attenuverterRange;
+
     if (modAttenuverters)
     {
-        modAmount = CenterMap(modAmount);
+        modAmount = attenuverterRange.Map(modAmount);
         // Deadband in the center.
         if (modAmount >= -0.1f && modAmount <= 0.1f)
         {
@@ -836,7 +1112,7 @@ float Modulate(
 
     if (cvAttenuverters)
     {
-        cvAmount = CenterMap(cvAmount);
+        cvAmount = attenuverterRange.Map(cvAmount);
         // Deadband in the center.
         if (cvAmount >= -0.1f && cvAmount <= 0.1f)
         {
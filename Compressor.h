@@ -79,13 +79,13 @@ public:
     void setAttack(float value)
     {
         attack_ = value;
-        cteAT_ = exp (-2.f * M_PI * 1000.f / attack_ / sampleRate_);
+        cteAT_ = FastExp(-k2Pi * 1000.f / attack_ / sampleRate_);
     }
 
     void setRelease(float value)
     {
         release_ = value;
-        cteRL_ = exp (-2.f * M_PI * 1000.f / release_ / sampleRate_);
+        cteRL_ = FastExp(-k2Pi * 1000.f / release_ / sampleRate_);
     }
 
     float process(float input)
@@ -3,24 +3,76 @@
 #include "Commons.h"
 #include "Interpolator.h"
 #include <stdint.h>
+#include <string.h>
 
+/**
+ * @brief DelayLine storage keeping the samples as they are written. They are
+ *        clamped to +/-3 when read.
+ */
+struct FloatDelayStorage
+{
+    typedef float Sample;
+
+    static inline Sample encode(float value)
+    {
+        return value;
+    }
+
+    static inline float decode(Sample sample)
+    {
+        return Clamp(sample, -3.f, 3.f);
+    }
+};
+
+/**
+ * @brief DelayLine storage keeping the samples as 16 bit integers. They are
+ *        clamped to +/-3 and scaled to full range when written, so storage
+ *        takes half the memory with a resolution of about 1e-4.
+ */
+struct Int16DelayStorage
+{
+    typedef int16_t Sample;
+
+    static constexpr float kScale = 32767.f / 3.f;
+    static constexpr float kRScale = 3.f / 32767.f;
+
+    static inline Sample encode(float value)
+    {
+        return (int16_t)rintf(Clamp(value, -3.f, 3.f) * kScale);
+    }
+
+    static inline float decode(Sample sample)
+    {
+        return sample * kRScale;
+    }
+};
+
+template<typename Storage = FloatDelayStorage>
 class DelayLine
 {
 private:
-    FloatArray buffer_;
+    typedef typename Storage::Sample Sample;
+
+    Sample* buffer_;
     uint32_t size_, writeIndex_, delay_;
 
+    inline float sample(uint32_t i)
+    {
+        return Storage::decode(buffer_[i]);
+    }
+
 public:
     DelayLine(uint32_t size)
     {
         size_ = size;
-        buffer_ = FloatArray::create(size_);
+        buffer_ = new Sample[size_];
         delay_ = size_ - 1;
         writeIndex_ = 0;
+        clear();
     }
     ~DelayLine()
     {
-        FloatArray::destroy(buffer_);
+        delete[] buffer_;
     }
 
     static DelayLine* create(uint32_t size)
@@ -35,7 +87,7 @@ public:
 
     void clear()
     {
-        buffer_.clear();
+        memset(buffer_, 0, size_ * sizeof(Sample));
     }
 
     void setDelay(uint32_t delay)
@@ -51,7 +103,7 @@ public:
             i += size_;
         }
 
-        return Clamp(buffer_[i], -3.f, 3.f);
+        return sample(i);
     }
 
     inline float read(float index)
@@ -77,11 +129,447 @@ public:
 
     inline void write(float value, int stride = 1)
     {
-        buffer_[writeIndex_] = value;
+        buffer_[writeIndex_] = Storage::encode(value);
         writeIndex_ += stride;
         if  (writeIndex_ >= size_)
         {
             writeIndex_ -= size_;
         }
     }
-};
\ No newline at end of file
+
+    /**
+     * @brief Writes a whole block, in at most two contiguous segments.
+     */
+    void writeBlock(FloatArray input)
+    {
+        uint32_t size = input.getSize();
+        uint32_t n = size_ - writeIndex_ < size ? size_ - writeIndex_ : size;
+
+        Sample* head = buffer_ + writeIndex_;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            head[i] = Storage::encode(input[i]);
+        }
+        for (uint32_t i = n; i < size; i++)
+        {
+            buffer_[i - n] = Storage::encode(input[i]);
+        }
+
+        writeIndex_ += size;
+        if (writeIndex_ >= size_)
+        {
+            writeIndex_ -= size_;
+        }
+    }
+
+    /**
+     * @brief Fills output[i] with what read(index) would return i writes
+     *        from now. The index must be at least the block size, so that
+     *        the block only reads samples already in the line.
+     */
+    void readBlock(FloatArray output, float index)
+    {
+        readBlock(output, index, index, 0.f, 0.f);
+    }
+
+    /**
+     * @brief Like readBlock(), for an index that moves by inc before every
+     *        sample.
+     */
+    void readRamp(FloatArray output, float index, float inc)
+    {
+        uint32_t size = output.getSize();
+        for (uint32_t i = 0; i < size; i++)
+        {
+            index += inc;
+            output[i] = read(index - i);
+        }
+    }
+
+    /**
+     * @brief Block version of the crossfaded read, with the crossfade
+     *        position starting at x and advancing by xi every sample.
+     */
+    void readBlock(FloatArray output, float index1, float index2, float x, float xi)
+    {
+        uint32_t size = output.getSize();
+        uint32_t idx1 = (uint32_t)index1;
+        uint32_t idx2 = (uint32_t)index2;
+        float frac1 = index1 - idx1;
+        float frac2 = index2 - idx2;
+
+        // Oldest of the two samples each output is interpolated from.
+        uint32_t q1 = writeIndex_ + 2 * size_ - idx1 - 2;
+        uint32_t q2 = writeIndex_ + 2 * size_ - idx2 - 2;
+        while (q1 >= size_)
+        {
+            q1 -= size_;
+        }
+        while (q2 >= size_)
+        {
+            q2 -= size_;
+        }
+
+        uint32_t i = 0;
+        while (i < size)
+        {
+            // Contiguous run where neither pair of samples crosses the wrap.
+            uint32_t n = size - i;
+            n = size_ - 1 - q1 < n ? size_ - 1 - q1 : n;
+            n = size_ - 1 - q2 < n ? size_ - 1 - q2 : n;
+
+            for (uint32_t j = 0; j < n; j++)
+            {
+                float v = Interpolator::linear(sample(q1 + 1), sample(q1), frac1);
+                if (x != 0)
+                {
+                    v = v * (1.f - x) + Interpolator::linear(sample(q2 + 1), sample(q2), frac2) * x;
+                }
+                output[i++] = v;
+                q1++;
+                q2++;
+                x += xi;
+            }
+
+            if (i < size)
+            {
+                // One of the pairs straddles the end of the buffer.
+                float v = Interpolator::linear(sample(q1 + 1 == size_ ? 0 : q1 + 1), sample(q1), frac1);
+                if (x != 0)
+                {
+                    v = v * (1.f - x) + Interpolator::linear(sample(q2 + 1 == size_ ? 0 : q2 + 1), sample(q2), frac2) * x;
+                }
+                output[i++] = v;
+                q1 = q1 + 1 == size_ ? 0 : q1 + 1;
+                q2 = q2 + 1 == size_ ? 0 : q2 + 1;
+                x += xi;
+            }
+        }
+    }
+};
+
+enum DelayLineSaturation
+{
+    SATURATE_ON_READ,
+    SATURATE_ON_WRITE,
+};
+
+/**
+ * @brief Delay line whose capacity is rounded up to a power of two, so that
+ *        indices wrap with a mask instead of a compare and add. Samples are
+ *        clamped to +/-3 either when read (like DelayLine) or once when
+ *        written, as chosen by the saturation policy.
+ */
+template<DelayLineSaturation saturation = SATURATE_ON_READ>
+class MaskedDelayLine
+{
+private:
+    FloatArray buffer_;
+    uint32_t size_, mask_, writeIndex_;
+
+    inline float sample(uint32_t i)
+    {
+        float v = buffer_[i];
+        if (SATURATE_ON_READ == saturation)
+        {
+            v = Clamp(v, -3.f, 3.f);
+        }
+
+        return v;
+    }
+
+public:
+    MaskedDelayLine(uint32_t size)
+    {
+        size_ = NextPowerOfTwo(size);
+        mask_ = size_ - 1;
+        buffer_ = FloatArray::create(size_);
+        writeIndex_ = 0;
+    }
+    ~MaskedDelayLine()
+    {
+        FloatArray::destroy(buffer_);
+    }
+
+    static MaskedDelayLine* create(uint32_t size)
+    {
+        return new MaskedDelayLine(size);
+    }
+
+    static void destroy(MaskedDelayLine* line)
+    {
+        delete line;
+    }
+
+    void clear()
+    {
+        buffer_.clear();
+    }
+
+    uint32_t getSize()
+    {
+        return size_;
+    }
+
+    inline float readAt(int index)
+    {
+        return sample((writeIndex_ - index - 1) & mask_);
+    }
+
+    inline float read(float index)
+    {
+        size_t idx = (size_t)index;
+        float y0 = readAt(idx);
+        float y1 = readAt(idx + 1);
+        float frac = index - idx;
+
+        return Interpolator::linear(y0, y1, frac);
+    }
+
+    inline float read(float index1, float index2, float x)
+    {
+        float v = read(index1);
+        if (x == 0)
+        {
+            return v;
+        }
+
+        return v * (1.f - x) + read(index2) * x;
+    }
+
+    inline void write(float value, int stride = 1)
+    {
+        if (SATURATE_ON_WRITE == saturation)
+        {
+            value = Clamp(value, -3.f, 3.f);
+        }
+        buffer_[writeIndex_] = value;
+        writeIndex_ = (writeIndex_ + stride) & mask_;
+    }
+
+    /**
+     * @brief Writes a whole block, in at most two contiguous segments.
+     */
+    void writeBlock(FloatArray input)
+    {
+        uint32_t size = input.getSize();
+        uint32_t n = size_ - writeIndex_ < size ? size_ - writeIndex_ : size;
+
+        FloatArray head = buffer_.subArray(writeIndex_, n);
+        head.copyFrom(input.subArray(0, n));
+        if (SATURATE_ON_WRITE == saturation)
+        {
+            head.clip(3.f);
+        }
+        if (n < size)
+        {
+            FloatArray tail = buffer_.subArray(0, size - n);
+            tail.copyFrom(input.subArray(n, size - n));
+            if (SATURATE_ON_WRITE == saturation)
+            {
+                tail.clip(3.f);
+            }
+        }
+
+        writeIndex_ = (writeIndex_ + size) & mask_;
+    }
+
+    /**
+     * @brief Fills output[i] with what read(index) would return i writes
+     *        from now. The index must be at least the block size, so that
+     *        the block only reads samples already in the line.
+     */
+    void readBlock(FloatArray output, float index)
+    {
+        readBlock(output, index, index, 0.f, 0.f);
+    }
+
+    /**
+     * @brief Like readBlock(), for an index that moves by inc before every
+     *        sample.
+     */
+    void readRamp(FloatArray output, float index, float inc)
+    {
+        uint32_t size = output.getSize();
+        for (uint32_t i = 0; i < size; i++)
+        {
+            index += inc;
+            output[i] = read(index - i);
+        }
+    }
+
+    /**
+     * @brief Block version of the crossfaded read, with the crossfade
+     *        position starting at x and advancing by xi every sample.
+     */
+    void readBlock(FloatArray output, float index1, float index2, float x, float xi)
+    {
+        uint32_t size = output.getSize();
+        uint32_t idx1 = (uint32_t)index1;
+        uint32_t idx2 = (uint32_t)index2;
+        float frac1 = index1 - idx1;
+        float frac2 = index2 - idx2;
+
+        // Oldest of the two samples each output is interpolated from.
+        uint32_t q1 = (writeIndex_ - idx1 - 2) & mask_;
+        uint32_t q2 = (writeIndex_ - idx2 - 2) & mask_;
+
+        uint32_t i = 0;
+        while (i < size)
+        {
+            // Contiguous run where neither pair of samples crosses the wrap.
+            uint32_t n = size - i;
+            n = mask_ - q1 < n ? mask_ - q1 : n;
+            n = mask_ - q2 < n ? mask_ - q2 : n;
+
+            for (uint32_t j = 0; j < n; j++)
+            {
+                float v = Interpolator::linear(sample(q1 + 1), sample(q1), frac1);
+                if (x != 0)
+                {
+                    v = v * (1.f - x) + Interpolator::linear(sample(q2 + 1), sample(q2), frac2) * x;
+                }
+                output[i++] = v;
+                q1++;
+                q2++;
+                x += xi;
+            }
+
+            if (i < size)
+            {
+                // One of the pairs straddles the end of the buffer.
+                float v = Interpolator::linear(sample((q1 + 1) & mask_), sample(q1), frac1);
+                if (x != 0)
+                {
+                    v = v * (1.f - x) + Interpolator::linear(sample((q2 + 1) & mask_), sample(q2), frac2) * x;
+                }
+                output[i++] = v;
+                q1 = (q1 + 1) & mask_;
+                q2 = (q2 + 1) & mask_;
+                x += xi;
+            }
+        }
+    }
+};
+
+/**
+ * @brief Stereo version of MaskedDelayLine, for two channels that always
+ *        share the same delay times. Samples are stored as interleaved
+ *        frames, so both channels are read and written with the same
+ *        indices. Block inputs and outputs are interleaved too.
+ */
+template<DelayLineSaturation saturation = SATURATE_ON_READ>
+class MaskedStereoDelayLine
+{
+private:
+    FloatArray buffer_;
+    uint32_t size_, mask_, writeIndex_;
+
+    inline float sample(uint32_t i, uint32_t channel)
+    {
+        float v = buffer_[(i << 1) + channel];
+        if (SATURATE_ON_READ == saturation)
+        {
+            v = Clamp(v, -3.f, 3.f);
+        }
+
+        return v;
+    }
+
+public:
+    MaskedStereoDelayLine(uint32_t size)
+    {
+        size_ = NextPowerOfTwo(size);
+        mask_ = size_ - 1;
+        buffer_ = FloatArray::create(size_ * 2);
+        writeIndex_ = 0;
+    }
+    ~MaskedStereoDelayLine()
+    {
+        FloatArray::destroy(buffer_);
+    }
+
+    static MaskedStereoDelayLine* create(uint32_t size)
+    {
+        return new MaskedStereoDelayLine(size);
+    }
+
+    static void destroy(MaskedStereoDelayLine* line)
+    {
+        delete line;
+    }
+
+    void clear()
+    {
+        buffer_.clear();
+    }
+
+    // Size in frames.
+    uint32_t getSize()
+    {
+        return size_;
+    }
+
+    /**
+     * @brief Writes a block of interleaved frames, in at most two contiguous
+     *        segments.
+     */
+    void writeBlock(FloatArray input)
+    {
+        uint32_t size = input.getSize() >> 1;
+        uint32_t n = size_ - writeIndex_ < size ? size_ - writeIndex_ : size;
+
+        FloatArray head = buffer_.subArray(writeIndex_ << 1, n << 1);
+        head.copyFrom(input.subArray(0, n << 1));
+        if (SATURATE_ON_WRITE == saturation)
+        {
+            head.clip(3.f);
+        }
+        if (n < size)
+        {
+            FloatArray tail = buffer_.subArray(0, (size - n) << 1);
+            tail.copyFrom(input.subArray(n << 1, (size - n) << 1));
+            if (SATURATE_ON_WRITE == saturation)
+            {
+                tail.clip(3.f);
+            }
+        }
+
+        writeIndex_ = (writeIndex_ + size) & mask_;
+    }
+
+    /**
+     * @brief Same as MaskedDelayLine::readBlock(), filling interleaved
+     *        frames.
+     */
+    void readBlock(FloatArray output, float index1, float index2, float x, float xi)
+    {
+        uint32_t size = output.getSize() >> 1;
+        uint32_t idx1 = (uint32_t)index1;
+        uint32_t idx2 = (uint32_t)index2;
+        float frac1 = index1 - idx1;
+        float frac2 = index2 - idx2;
+
+        uint32_t q1 = (writeIndex_ - idx1 - 2) & mask_;
+        uint32_t q2 = (writeIndex_ - idx2 - 2) & mask_;
+
+        float* out = output.getData();
+        for (uint32_t i = 0; i < size; i++)
+        {
+            uint32_t p1 = (q1 + 1) & mask_;
+            uint32_t p2 = (q2 + 1) & mask_;
+            for (uint32_t c = 0; c < 2; c++)
+            {
+                float v = Interpolator::linear(sample(p1, c), sample(q1, c), frac1);
+                if (x != 0)
+                {
+                    v = v * (1.f - x) + Interpolator::linear(sample(p2, c), sample(q2, c), frac2) * x;
+                }
+                *out++ = v;
+            }
+            q1 = p1;
+            q2 = p2;
+            x += xi;
+        }
+    }
+};
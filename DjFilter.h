@@ -81,20 +81,20 @@ public:
         if (value <= 0.45f)
         {
             filter_ = FilterType::LP;
-            lpfMix_ = Map(value, 0.f, 0.45f, 1.f, 0.f);
-            freq_ = Map(lpfMix_, 0.f, 1.f, 200.f, 30.f);
-            reso_ = Map(lpfMix_, 0.f, 1.f, 0.1f, FilterStage::BUTTERWORTH_Q);
+            lpfMix_ = Range(0.f, 0.45f, 1.f, 0.f).Map(value);
+            freq_ = Range(0.f, 1.f, 200.f, 30.f).Map(lpfMix_);
+            reso_ = Range(0.f, 1.f, 0.1f, FilterStage::BUTTERWORTH_Q).Map(lpfMix_);
             UpdateFilter();
-            amp_ = Map(lpfMix_, 0.f, 1.f, kDjFilterMakeupGainMin, kDjFilterMakeupGainMaxLp);
+            amp_ = Range(0.f, 1.f, kDjFilterMakeupGainMin, kDjFilterMakeupGainMaxLp).Map(lpfMix_);
         }
         else if (value >= 0.55f)
         {
             filter_ = FilterType::HP;
-            hpfMix_ = Map(value, 0.55f, 1.f, 0.f, 1.f);
-            freq_ = Map(hpfMix_, 0.f, 1.f, 2000.f, 4000.f);
-            reso_ = Map(hpfMix_, 0.f, 1.f, 0.1f, FilterStage::BUTTERWORTH_Q);
+            hpfMix_ = Range(0.55f, 1.f, 0.f, 1.f).Map(value);
+            freq_ = Range(0.f, 1.f, 2000.f, 4000.f).Map(hpfMix_);
+            reso_ = Range(0.f, 1.f, 0.1f, FilterStage::BUTTERWORTH_Q).Map(hpfMix_);
             UpdateFilter();
-            amp_ = Map(hpfMix_, 0.f, 1.f, kDjFilterMakeupGainMin, kDjFilterMakeupGainMaxHp);
+            amp_ = Range(0.f, 1.f, kDjFilterMakeupGainMin, kDjFilterMakeupGainMaxHp).Map(hpfMix_);
         }
         else
         {
@@ -8,6 +8,17 @@
 #include "DjFilter.h"
 #include "Compressor.h"
 #include <stdint.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#ifdef USE_ECHO_INT16
+typedef DelayLine<Int16DelayStorage> EchoDelayLine;
+#else
+typedef DelayLine<> EchoDelayLine;
+#endif
 
 enum EchoTap
 {
@@ -24,27 +35,34 @@ private:
     PatchCvs* patchCvs_;
     PatchState* patchState_;
 
-    DelayLine* lines_[kEchoTaps];
+    EchoDelayLine* lines_[2];
+    FloatArray taps_[kEchoTaps], fbs_[2], wets_[2];
     DjFilter* filter_;
-    EnvFollower* ef_[2];
+    EnvFollowerBank<2> ef_;
     Compressor* comp_[2];
+    EqualPowerCrossFader crossFader_;
 
     HysteresisQuantizer densityQuantizer_;
 
     int clockRatiosIndex_;
-    float echoDensity_, oldDensity_;
+    float echoDensity_, oldDensity_, densityBlockCoeff_;
 
-    float levels_[kEchoTaps], outs_[kEchoTaps];
-    float tapsTimes_[kEchoTaps], newTapsTimes_[kEchoTaps], maxTapsTimes_[kEchoTaps];
+    float levels_[kEchoTaps];
+    float tapsTimes_[kEchoTaps], newTapsTimes_[kEchoTaps], maxTapsTimes_[kEchoTaps], tapsIncs_[kEchoTaps];
     float repeats_, filterValue_;
+    ChangeTracker filterChange_, repeatsChange_;
     float xi_;
 
     bool externalClock_;
     bool infinite_;
 
+    // The taps are read for the whole block before the lines are written,
+    // so none can be shorter than a block (TAP_LEFT_B goes down to 120
+    // samples otherwise).
     void SetTapTime(int idx, float time)
     {
-        newTapsTimes_[idx] = Clamp(time, kEchoMinLengthSamples * kEchoTapsRatios[idx], (kEchoMaxLengthSamples - 1) * kEchoTapsRatios[idx]);
+        float min = Max(kEchoMinLengthSamples * kEchoTapsRatios[idx], patchState_->blockSize);
+        newTapsTimes_[idx] = Clamp(time, min, (kEchoMaxLengthSamples - 1) * kEchoTapsRatios[idx]);
     }
 
     void SetMaxTapTime(int idx, float time)
@@ -75,7 +93,7 @@ private:
         SetLevel(TAP_RIGHT_A, value * kEchoTapsFeedbacks[TAP_RIGHT_A]);
         SetLevel(TAP_RIGHT_B, value * kEchoTapsFeedbacks[TAP_RIGHT_B]);
 
-        float thrs = Map(value, 0.f, 1.f, kEchoCompThresMin, kEchoCompThresMax);
+        float thrs = Range(0.f, 1.f, kEchoCompThresMin, kEchoCompThresMax).Map(value);
         comp_[LEFT_CHANNEL]->setThreshold(thrs);
         comp_[RIGHT_CHANNEL]->setThreshold(thrs);
     }
@@ -117,18 +135,91 @@ private:
 
             echoDensity_ = value;
 
-            float d = Clamp(MapExpo(echoDensity_, 0.f, 0.97f, kEchoMinLengthSamples, kEchoMaxLengthSamples), kEchoMinLengthSamples, kEchoMaxLengthSamples);
-            size_t s = kEchoFadeSamples;
-            ParameterInterpolator densityParam(&oldDensity_, d, s);
-            float de = densityParam.Next();
+            // The density glides towards its target with a one pole filter
+            // (that's what gives the pitch shifting effect). Advance it by a
+            // whole block here, the taps then ramp linearly to it.
+            constexpr ExpoRange densityRange(0.f, 0.97f, kEchoMinLengthSamples, kEchoMaxLengthSamples);
+            float d = Clamp(densityRange.Map(echoDensity_), kEchoMinLengthSamples, kEchoMaxLengthSamples);
+            oldDensity_ = d + (oldDensity_ - d) * densityBlockCoeff_;
 
             for (size_t i = 0; i < kEchoTaps; i++)
             {
-                SetTapTime(i, de * kEchoTapsRatios[i]);
+                SetTapTime(i, oldDensity_ * kEchoTapsRatios[i]);
+                tapsIncs_[i] = (newTapsTimes_[i] - tapsTimes_[i]) * xi_;
             }
         }
     }
 
+    /**
+     * @brief Sums the taps read for the block into the feedback signals
+     *        (fbs_) and the wet signals (wets_), four samples at a time.
+     */
+    void ProcessTaps(size_t size)
+    {
+        const float* la = taps_[TAP_LEFT_A].getData();
+        const float* lb = taps_[TAP_LEFT_B].getData();
+        const float* ra = taps_[TAP_RIGHT_A].getData();
+        const float* rb = taps_[TAP_RIGHT_B].getData();
+        float* leftFb = fbs_[LEFT_CHANNEL].getData();
+        float* rightFb = fbs_[RIGHT_CHANNEL].getData();
+        float* left = wets_[LEFT_CHANNEL].getData();
+        float* right = wets_[RIGHT_CHANNEL].getData();
+
+        size_t i = 0;
+
+#if defined(__ARM_NEON)
+        float32x4_t vla = vdupq_n_f32(levels_[TAP_LEFT_A]);
+        float32x4_t vlb = vdupq_n_f32(levels_[TAP_LEFT_B]);
+        float32x4_t vra = vdupq_n_f32(levels_[TAP_RIGHT_A]);
+        float32x4_t vrb = vdupq_n_f32(levels_[TAP_RIGHT_B]);
+        float32x4_t one = vdupq_n_f32(1.f);
+        float32x4_t minusOne = vdupq_n_f32(-1.f);
+        float32x4_t mix = vdupq_n_f32(0.707f);
+        for (; i + 4 <= size; i += 4)
+        {
+            float32x4_t a = vld1q_f32(la + i);
+            float32x4_t b = vld1q_f32(lb + i);
+            float32x4_t c = vld1q_f32(ra + i);
+            float32x4_t d = vld1q_f32(rb + i);
+            float32x4_t l = vaddq_f32(vmulq_f32(a, vla), vmulq_f32(c, vra));
+            float32x4_t r = vaddq_f32(vmulq_f32(b, vlb), vmulq_f32(d, vrb));
+            vst1q_f32(leftFb + i, vminq_f32(vmaxq_f32(l, minusOne), one));
+            vst1q_f32(rightFb + i, vminq_f32(vmaxq_f32(r, minusOne), one));
+            vst1q_f32(left + i, vmulq_f32(vaddq_f32(a, b), mix));
+            vst1q_f32(right + i, vmulq_f32(vaddq_f32(c, d), mix));
+        }
+#elif defined(__SSE__)
+        __m128 vla = _mm_set1_ps(levels_[TAP_LEFT_A]);
+        __m128 vlb = _mm_set1_ps(levels_[TAP_LEFT_B]);
+        __m128 vra = _mm_set1_ps(levels_[TAP_RIGHT_A]);
+        __m128 vrb = _mm_set1_ps(levels_[TAP_RIGHT_B]);
+        __m128 one = _mm_set1_ps(1.f);
+        __m128 minusOne = _mm_set1_ps(-1.f);
+        __m128 mix = _mm_set1_ps(0.707f);
+        for (; i + 4 <= size; i += 4)
+        {
+            __m128 a = _mm_loadu_ps(la + i);
+            __m128 b = _mm_loadu_ps(lb + i);
+            __m128 c = _mm_loadu_ps(ra + i);
+            __m128 d = _mm_loadu_ps(rb + i);
+            __m128 l = _mm_add_ps(_mm_mul_ps(a, vla), _mm_mul_ps(c, vra));
+            __m128 r = _mm_add_ps(_mm_mul_ps(b, vlb), _mm_mul_ps(d, vrb));
+            _mm_storeu_ps(leftFb + i, _mm_min_ps(_mm_max_ps(l, minusOne), one));
+            _mm_storeu_ps(rightFb + i, _mm_min_ps(_mm_max_ps(r, minusOne), one));
+            _mm_storeu_ps(left + i, _mm_mul_ps(_mm_add_ps(a, b), mix));
+            _mm_storeu_ps(right + i, _mm_mul_ps(_mm_add_ps(c, d), mix));
+        }
+#endif
+
+        for (; i < size; i++)
+        {
+            leftFb[i] = HardClip(la[i] * levels_[TAP_LEFT_A] + ra[i] * levels_[TAP_RIGHT_A]);
+            rightFb[i] = HardClip(lb[i] * levels_[TAP_LEFT_B] + rb[i] * levels_[TAP_RIGHT_B]);
+            left[i] = Mix2(la[i], lb[i]);
+            right[i] = Mix2(ra[i], rb[i]);
+        }
+    }
+
 public:
     Echo(PatchCtrls* patchCtrls, PatchCvs* patchCvs, PatchState* patchState)
     {
@@ -136,19 +227,30 @@ public:
         patchCvs_ = patchCvs;
         patchState_ = patchState;
 
-        for (size_t i = 0; i < kEchoTaps; i++)
+        // Taps on the same side share the same feedback signal, so one line
+        // per channel is read by all of its taps.
+        for (size_t i = 0; i < 2; i++)
         {
-            lines_[i] = DelayLine::create(kEchoMaxLengthSamples);
-            tapsTimes_[i] = kEchoMaxLengthSamples - 1;
-            SetMaxTapTime(i, tapsTimes_[i] * kEchoTapsRatios[i]);
-            levels_[i] = 0;
-            outs_[i] = 0;
+            lines_[i] = EchoDelayLine::create(kEchoMaxLengthSamples);
+            fbs_[i] = FloatArray::create(patchState_->blockSize);
+            wets_[i] = FloatArray::create(patchState_->blockSize);
         }
 
         echoDensity_ = 1.f;
+        oldDensity_ = kEchoMaxLengthSamples;
         clockRatiosIndex_ = 0;
 
         xi_ = 1.f / patchState_->blockSize;
+        densityBlockCoeff_ = fast_powf(1.f - 1.f / kEchoFadeSamples, patchState_->blockSize);
+
+        for (size_t i = 0; i < kEchoTaps; i++)
+        {
+            taps_[i] = FloatArray::create(patchState_->blockSize);
+            SetMaxTapTime(i, (kEchoMaxLengthSamples - 1) * kEchoTapsRatios[i]);
+            tapsTimes_[i] = newTapsTimes_[i];
+            tapsIncs_[i] = 0;
+            levels_[i] = 0;
+        }
 
         externalClock_ = false;
         infinite_ = false;
@@ -159,22 +261,26 @@ public:
         {
             comp_[i] = Compressor::create(patchState_->sampleRate);
             comp_[i]->setThreshold(-16);
-            ef_[i] = EnvFollower::create();
         }
 
         densityQuantizer_.Init(kClockUnityRatioIndex, 0.15f, false);
     }
     ~Echo()
     {
+        for (size_t i = 0; i < 2; i++)
+        {
+            EchoDelayLine::destroy(lines_[i]);
+            FloatArray::destroy(fbs_[i]);
+            FloatArray::destroy(wets_[i]);
+        }
         for (size_t i = 0; i < kEchoTaps; i++)
         {
-            DelayLine::destroy(lines_[i]);
+            FloatArray::destroy(taps_[i]);
         }
         DjFilter::destroy(filter_);
         for (size_t i = 0; i < 2; i++)
         {
             Compressor::destroy(comp_[i]);
-            EnvFollower::destroy(ef_[i]);
         }
     }
 
@@ -196,44 +302,49 @@ public:
         FloatArray leftOut = output.getSamples(LEFT_CHANNEL);
         FloatArray rightOut = output.getSamples(RIGHT_CHANNEL);
 
-        SetFilter(patchCtrls_->echoFilter);
-
-        float d = Modulate(patchCtrls_->echoDensity, patchCtrls_->echoDensityModAmount, patchState_->modValue, patchCtrls_->echoDensityCvAmount, patchCvs_->echoDensity, -1.f, 1.f, patchState_->modAttenuverters, patchState_->cvAttenuverters);
-        if (externalClock_)
+        if (filterChange_.Changed(patchCtrls_->echoFilter))
         {
-            SetDensity(d);
+            SetFilter(filterChange_.Get());
         }
 
-        float r = Modulate(patchCtrls_->echoRepeats, patchCtrls_->echoRepeatsModAmount, patchState_->modValue, patchCtrls_->echoRepeatsCvAmount, patchCvs_->echoRepeats, -1.f, 1.f, patchState_->modAttenuverters, patchState_->cvAttenuverters);
-        SetRepeats(r);
+        // Once per block, before the taps are read: it can switch between
+        // the clock modes.
+        float d = Modulate(patchCtrls_->echoDensity, patchCtrls_->echoDensityModAmount, patchState_->modValue, patchCtrls_->echoDensityCvAmount, patchCvs_->echoDensity, -1.f, 1.f, patchState_->modAttenuverters, patchState_->cvAttenuverters);
+        SetDensity(d);
 
-        float x = 0;
+        float r = Modulate(patchCtrls_->echoRepeats, patchCtrls_->echoRepeatsModAmount, patchState_->modValue, patchCtrls_->echoRepeatsCvAmount, patchCvs_->echoRepeats, -1.f, 1.f, patchState_->modAttenuverters, patchState_->cvAttenuverters);
+        if (repeatsChange_.Changed(r))
+        {
+            SetRepeats(r);
+        }
 
-        for (int i = 0; i < size; i++)
+        // Read all the taps for the block first. The lines are written once
+        // at the end of it and tap times are never shorter than a block, so
+        // every read only sees samples written before.
+        // Using crossfade between two different tap times when the clock is
+        // external and a filtered density param for when the clock is
+        // internal (for pitch shifting effect).
+        if (externalClock_)
         {
-            // Using crossfade between two different tap times when the clock is
-            // external and a filtered density param for when the clock is
-            // internal (for pitch shifting effect).
-            if (externalClock_)
-            {
-                outs_[TAP_LEFT_A] = lines_[TAP_LEFT_A]->read(tapsTimes_[TAP_LEFT_A], newTapsTimes_[TAP_LEFT_A], x); // A
-                outs_[TAP_LEFT_B] = lines_[TAP_LEFT_B]->read(tapsTimes_[TAP_LEFT_B], newTapsTimes_[TAP_LEFT_B], x); // B
-                outs_[TAP_RIGHT_A] = lines_[TAP_RIGHT_A]->read(tapsTimes_[TAP_RIGHT_A], newTapsTimes_[TAP_RIGHT_A], x); // A
-                outs_[TAP_RIGHT_B] = lines_[TAP_RIGHT_B]->read(tapsTimes_[TAP_RIGHT_B], newTapsTimes_[TAP_RIGHT_B], x); // B
+            lines_[LEFT_CHANNEL]->readBlock(taps_[TAP_LEFT_A].subArray(0, size), tapsTimes_[TAP_LEFT_A], newTapsTimes_[TAP_LEFT_A], 0.f, xi_); // A
+            lines_[LEFT_CHANNEL]->readBlock(taps_[TAP_LEFT_B].subArray(0, size), tapsTimes_[TAP_LEFT_B], newTapsTimes_[TAP_LEFT_B], 0.f, xi_); // B
+            lines_[RIGHT_CHANNEL]->readBlock(taps_[TAP_RIGHT_A].subArray(0, size), tapsTimes_[TAP_RIGHT_A], newTapsTimes_[TAP_RIGHT_A], 0.f, xi_); // A
+            lines_[RIGHT_CHANNEL]->readBlock(taps_[TAP_RIGHT_B].subArray(0, size), tapsTimes_[TAP_RIGHT_B], newTapsTimes_[TAP_RIGHT_B], 0.f, xi_); // B
+        }
+        else
+        {
+            lines_[LEFT_CHANNEL]->readRamp(taps_[TAP_LEFT_A].subArray(0, size), tapsTimes_[TAP_LEFT_A], tapsIncs_[TAP_LEFT_A]); // A
+            lines_[LEFT_CHANNEL]->readRamp(taps_[TAP_LEFT_B].subArray(0, size), tapsTimes_[TAP_LEFT_B], tapsIncs_[TAP_LEFT_B]); // B
+            lines_[RIGHT_CHANNEL]->readRamp(taps_[TAP_RIGHT_A].subArray(0, size), tapsTimes_[TAP_RIGHT_A], tapsIncs_[TAP_RIGHT_A]); // A
+            lines_[RIGHT_CHANNEL]->readRamp(taps_[TAP_RIGHT_B].subArray(0, size), tapsTimes_[TAP_RIGHT_B], tapsIncs_[TAP_RIGHT_B]); // B
+        }
 
-                x += xi_;
-            }
-            else
-            {
-                SetDensity(d);
-                outs_[TAP_LEFT_A] = lines_[TAP_LEFT_A]->read(newTapsTimes_[TAP_LEFT_A]); // A
-                outs_[TAP_LEFT_B] = lines_[TAP_LEFT_B]->read(newTapsTimes_[TAP_LEFT_B]); // B
-                outs_[TAP_RIGHT_A] = lines_[TAP_RIGHT_A]->read(newTapsTimes_[TAP_RIGHT_A]); // A
-                outs_[TAP_RIGHT_B] = lines_[TAP_RIGHT_B]->read(newTapsTimes_[TAP_RIGHT_B]); // B
-            }
+        ProcessTaps(size);
 
-            float leftFb = HardClip(outs_[TAP_LEFT_A] * levels_[TAP_LEFT_A] + outs_[TAP_RIGHT_A] * levels_[TAP_RIGHT_A]);
-            float rightFb = HardClip(outs_[TAP_LEFT_B] * levels_[TAP_LEFT_B] + outs_[TAP_RIGHT_B] * levels_[TAP_RIGHT_B]);
+        for (size_t i = 0; i < size; i++)
+        {
+            float leftFb = fbs_[LEFT_CHANNEL][i];
+            float rightFb = fbs_[RIGHT_CHANNEL][i];
 
             float lIn = Clamp(leftIn[i], -3.f, 3.f);
             float rIn = Clamp(rightIn[i], -3.f, 3.f);
@@ -248,31 +359,34 @@ public:
 
             if (infinite_)
             {
-                leftFb *= repeats_ * kEchoInfiniteFeedbackLevel - ef_[LEFT_CHANNEL]->process(leftFb);
-                rightFb *= repeats_* kEchoInfiniteFeedbackLevel - ef_[RIGHT_CHANNEL]->process(rightFb);
+                float fbs[2] = { leftFb, rightFb };
+                float envs[2];
+                ef_.process(fbs, envs);
+                leftFb *= repeats_ * kEchoInfiniteFeedbackLevel - envs[LEFT_CHANNEL];
+                rightFb *= repeats_* kEchoInfiniteFeedbackLevel - envs[RIGHT_CHANNEL];
             }
             
-            lines_[TAP_LEFT_A]->write(leftFb);
-            lines_[TAP_LEFT_B]->write(leftFb);
-            lines_[TAP_RIGHT_A]->write(rightFb);
-            lines_[TAP_RIGHT_B]->write(rightFb);
-
-            float left = Mix2(outs_[TAP_LEFT_A], outs_[TAP_LEFT_B]);
-            float right = Mix2(outs_[TAP_RIGHT_A], outs_[TAP_RIGHT_B]);
+            fbs_[LEFT_CHANNEL][i] = leftFb;
+            fbs_[RIGHT_CHANNEL][i] = rightFb;
 
-            left = comp_[LEFT_CHANNEL]->process(left) * kEchoMakeupGain;
-            right = comp_[RIGHT_CHANNEL]->process(right) * kEchoMakeupGain;
+            wets_[LEFT_CHANNEL][i] = comp_[LEFT_CHANNEL]->process(wets_[LEFT_CHANNEL][i]) * kEchoMakeupGain;
+            wets_[RIGHT_CHANNEL][i] = comp_[RIGHT_CHANNEL]->process(wets_[RIGHT_CHANNEL][i]) * kEchoMakeupGain;
 
-            leftOut[i] = CheapEqualPowerCrossFade(lIn, left, patchCtrls_->echoVol);
-            rightOut[i] = CheapEqualPowerCrossFade(rIn, right, patchCtrls_->echoVol);
+            // The output holds the dry signal until the crossfade.
+            leftOut[i] = lIn;
+            rightOut[i] = rIn;
         }
 
-        if (externalClock_)
+        crossFader_.SetPos(patchCtrls_->echoVol);
+        crossFader_.Process(leftOut, wets_[LEFT_CHANNEL].subArray(0, size), leftOut);
+        crossFader_.Process(rightOut, wets_[RIGHT_CHANNEL].subArray(0, size), rightOut);
+
+        lines_[LEFT_CHANNEL]->writeBlock(fbs_[LEFT_CHANNEL].subArray(0, size));
+        lines_[RIGHT_CHANNEL]->writeBlock(fbs_[RIGHT_CHANNEL].subArray(0, size));
+
+        for (size_t j = 0; j < kEchoTaps; j++)
         {
-            for (size_t j = 0; j < kEchoTaps; j++)
-            {
-                tapsTimes_[j] = newTapsTimes_[j];
-            }
+            tapsTimes_[j] = newTapsTimes_[j];
         }
     }
 };
\ No newline at end of file
@@ -40,3 +40,91 @@ public:
         return Clamp(y_);
     }
 };
+
+/**
+ * @brief N EnvFollower with their states stored contiguously, updated
+ *        together. Cheap to copy, for saving and restoring the state.
+ */
+template <int channels>
+class EnvFollowerBank
+{
+private:
+    float lambda_[channels];
+    float y_[channels];
+
+public:
+    EnvFollowerBank()
+    {
+        for (int c = 0; c < channels; c++)
+        {
+            lambda_[c] = 0.995f;
+            y_[c] = 0;
+        }
+    }
+    ~EnvFollowerBank() {}
+
+    static EnvFollowerBank* create()
+    {
+        return new EnvFollowerBank();
+    }
+    static void destroy(EnvFollowerBank* obj)
+    {
+        delete obj;
+    }
+
+    void setLambda(float lambda)
+    {
+        for (int c = 0; c < channels; c++)
+        {
+            lambda_[c] = lambda;
+        }
+    }
+
+    void setLambda(int channel, float lambda)
+    {
+        lambda_[channel] = lambda;
+    }
+
+    /**
+     * @brief One sample of every channel, for followers inside a
+     *        per-sample loop.
+     *
+     * @param input One sample per channel
+     * @param output The envelope of each channel
+     */
+    void process(const float* input, float* output)
+    {
+        for (int c = 0; c < channels; c++)
+        {
+            float v = fabs(HardClip(input[c]));
+            y_[c] = y_[c] * lambda_[c] + v * (1.0f - lambda_[c]);
+            output[c] = Clamp(y_[c]);
+        }
+    }
+
+    /**
+     * @brief A block of every channel, the state of each one stays in a
+     *        register through the block.
+     *
+     * @param input One array per channel
+     * @param output One array per channel, can be the input
+     */
+    void process(FloatArray* input, FloatArray* output)
+    {
+        for (int c = 0; c < channels; c++)
+        {
+            const size_t size = input[c].getSize();
+            const float* in = input[c].getData();
+            float* out = output[c].getData();
+            const float l = lambda_[c];
+            float y = y_[c];
+            for (size_t i = 0; i < size; i++)
+            {
+                float v = fabs(HardClip(in[i]));
+                y = y * l + v * (1.0f - l);
+                out[i] = Clamp(y);
+            }
+            y_[c] = y;
+        }
+    }
+};
@@ -46,8 +46,8 @@ public:
     float generate() override
     {
         // Smooth the envelope.
-        float l = MapExpo(patchCtrls_->modSpeed, 0.f, 0.97f, 0.998f, 0.85f);
-        s_ = s_* l + Map(patchState_->inputLevel.getRms(), 0, 0.6f, -0.5f, 0.5f) * (1.f - l);
+        float l = ExpoRange(0.f, 0.97f, 0.998f, 0.85f).Map(patchCtrls_->modSpeed);
+        s_ = s_* l + Range(0, 0.6f, -0.5f, 0.5f).Map(patchState_->inputLevel.getRms()) * (1.f - l);
 
         return s_;
     }
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "FloatArray.h"
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Approximations of exp2, log2 and the functions built on them, for the
+ * control and the audio paths. Measured bounds, rounding included:
+ * - FastExp2:      relative error < 2e-7, 5th order minimax polynomial
+ * - FastExp2Table: relative error < 2e-6, 32 entries table and a 2nd
+ *                  order correction
+ * - FastLog2:      absolute error < 5e-7 in [1/16, 16], relative error
+ *                  < 2e-7 beyond. 7th order minimax polynomial, x must
+ *                  be > 0
+ * - FastPow:       relative error < 2e-7 * (1 + |y| + |y * log2(x)|), x > 0.
+ *                  The absolute error of FastLog2 is scaled by y
+ * - FastDb2A:      relative error < 1e-6 within +/-160dB
+ * - FastM2F:       relative error < 1e-6 for notes in [-40, 160]
+ */
+
+constexpr float kLog2E = 1.442695041f;
+constexpr float kLog2Of10 = 3.321928095f;
+
+constexpr float kExp2Table[32] = {
+    1.000000000e+00f,
+    1.021897149e+00f,
+    1.044273782e+00f,
+    1.067140401e+00f,
+    1.090507733e+00f,
+    1.114386743e+00f,
+    1.138788635e+00f,
+    1.163724859e+00f,
+    1.189207115e+00f,
+    1.215247360e+00f,
+    1.241857812e+00f,
+    1.269050957e+00f,
+    1.296839555e+00f,
+    1.325236643e+00f,
+    1.354255547e+00f,
+    1.383909882e+00f,
+    1.414213562e+00f,
+    1.445180807e+00f,
+    1.476826146e+00f,
+    1.509164428e+00f,
+    1.542210825e+00f,
+    1.575980845e+00f,
+    1.610490332e+00f,
+    1.645755478e+00f,
+    1.681792831e+00f,
+    1.718619298e+00f,
+    1.756252160e+00f,
+    1.794709075e+00f,
+    1.834008086e+00f,
+    1.874167634e+00f,
+    1.915206561e+00f,
+    1.957144124e+00f,
+};
+
+/**
+ * @brief Slow but constexpr 2^x, for tables generated at compile time.
+ */
+constexpr float ConstExp2(float x)
+{
+    int i = x < 0 ? int(x) - 1 : int(x);
+    double f = (x - i) * 0.6931471805599453;
+
+    // Taylor series of e^f, f in [0, ln(2)).
+    double y = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 16; k++)
+    {
+        term *= f / k;
+        y += term;
+    }
+    for (; i > 0; i--)
+    {
+        y *= 2.0;
+    }
+    for (; i < 0; i++)
+    {
+        y *= 0.5;
+    }
+
+    return float(y);
+}
+
+/**
+ * @brief Slow but constexpr log2(x) for x > 0, for tables generated at
+ *        compile time.
+ */
+constexpr float ConstLog2(float x)
+{
+    double m = x;
+    int e = 0;
+    while (m >= 2.0)
+    {
+        m *= 0.5;
+        e++;
+    }
+    while (m < 1.0)
+    {
+        m *= 2.0;
+        e--;
+    }
+
+    // ln(m) = 2 * atanh((m - 1) / (m + 1)), m in [1, 2).
+    double t = (m - 1.0) / (m + 1.0);
+    double t2 = t * t;
+    double sum = 0.0;
+    double power = t;
+    for (int k = 0; k < 16; k++)
+    {
+        sum += power / (2 * k + 1);
+        power *= t2;
+    }
+
+    return float(e + 2.0 * sum * 1.4426950408889634);
+}
+
+// Conversion and compare rather than a call to floorf().
+inline int32_t FloorToInt(float x)
+{
+    int32_t i = (int32_t)x;
+
+    return x < i ? i - 1 : i;
+}
+
+// Multiplies by 2^e by adding to the exponent bits. A multiplication
+// rather than a shift, that is undefined for negative values of e.
+inline float ScaleByPowerOfTwo(float x, int32_t e)
+{
+    int32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    bits += e * (1 << 23);
+    memcpy(&x, &bits, sizeof(x));
+
+    return x;
+}
+
+/**
+ * @brief 2^x, saturates below -126 and above 127.
+ */
+inline float FastExp2(float x)
+{
+    x = x < -126.f ? -126.f : (x > 127.f ? 127.f : x);
+    int32_t i = FloorToInt(x);
+    float f = x - i;
+
+    float p = 1.877576700e-03f;
+    p = p * f + 8.989340024e-03f;
+    p = p * f + 5.582631812e-02f;
+    p = p * f + 2.401536170e-01f;
+    p = p * f + 6.931530732e-01f;
+    p = p * f + 9.999999251e-01f;
+
+    return ScaleByPowerOfTwo(p, i);
+}
+
+/**
+ * @brief 2^x from a table of the 32nd of an octave, cheaper and less
+ *        accurate than FastExp2(). Saturates like it.
+ */
+inline float FastExp2Table(float x)
+{
+    x = x < -126.f ? -126.f : (x > 127.f ? 127.f : x);
+    int32_t i = FloorToInt(x);
+    float f = (x - i) * 32.f;
+    int32_t k = (int32_t)f;
+    float r = (f - k) * (0.693147181f / 32.f);
+
+    float p = kExp2Table[k] * (1.f + r * (1.f + r * 0.5f));
+
+    return ScaleByPowerOfTwo(p, i);
+}
+
+/**
+ * @brief log2(x) for x > 0.
+ */
+inline float FastLog2(float x)
+{
+    int32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int32_t e = ((bits >> 23) & 0xff) - 127;
+    bits = (bits & 0x007fffff) | 0x3f800000;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+
+    // Center the mantissa around 1, in [sqrt(0.5), sqrt(2)).
+    if (m > 1.414213562f)
+    {
+        m *= 0.5f;
+        e++;
+    }
+    float t = m - 1.f;
+
+    float p = 1.711239697e-01f;
+    p = p * t - 2.736498248e-01f;
+    p = p * t + 2.974391545e-01f;
+    p = p * t - 3.588048164e-01f;
+    p = p * t + 4.804354984e-01f;
+    p = p * t - 7.213841894e-01f;
+    p = p * t + 1.442700640e+00f;
+    p = p * t + 1.323733011e-07f;
+
+    return p + e;
+}
+
+/**
+ * @brief x^y for x > 0.
+ */
+inline float FastPow(float x, float y)
+{
+    return FastExp2(y * FastLog2(x));
+}
+
+inline float FastExp(float x)
+{
+    return FastExp2(x * kLog2E);
+}
+
+inline float FastLog(float x)
+{
+    return FastLog2(x) * (1.f / kLog2E);
+}
+
+/**
+ * @brief Decibels to amplitude.
+ */
+inline float FastDb2A(float db)
+{
+    return FastExp2(db * (kLog2Of10 / 20.f));
+}
+
+/**
+ * @brief MIDI note to frequency, A4 (69) is 440Hz.
+ */
+inline float FastM2F(float note)
+{
+    return FastExp2((note - 69.f) * (1.f / 12.f)) * 440.f;
+}
+
+inline void FastExp2(FloatArray input, FloatArray output)
+{
+    size_t size = input.getSize();
+    const float* in = input.getData();
+    float* out = output.getData();
+    for (size_t i = 0; i < size; i++)
+    {
+        out[i] = FastExp2(in[i]);
+    }
+}
+
+inline void FastLog2(FloatArray input, FloatArray output)
+{
+    size_t size = input.getSize();
+    const float* in = input.getData();
+    float* out = output.getData();
+    for (size_t i = 0; i < size; i++)
+    {
+        out[i] = FastLog2(in[i]);
+    }
+}
+
+inline void FastPow(FloatArray input, float y, FloatArray output)
+{
+    size_t size = input.getSize();
+    const float* in = input.getData();
+    float* out = output.getData();
+    for (size_t i = 0; i < size; i++)
+    {
+        out[i] = FastPow(in[i], y);
+    }
+}
+
+inline void FastDb2A(FloatArray input, FloatArray output)
+{
+    size_t size = input.getSize();
+    const float* in = input.getData();
+    float* out = output.getData();
+    for (size_t i = 0; i < size; i++)
+    {
+        out[i] = FastDb2A(in[i]);
+    }
+}
+
+inline void FastM2F(FloatArray input, FloatArray output)
+{
+    size_t size = input.getSize();
+    const float* in = input.getData();
+    float* out = output.getData();
+    for (size_t i = 0; i < size; i++)
+    {
+        out[i] = FastM2F(in[i]);
+    }
+}
@@ -1,11 +1,9 @@
 #pragma once
 
 #include "Commons.h"
-#include "StateVariableFilter.h"
 #include "ChaosNoise.h"
 #include "DcBlockingFilter.h"
 #include "EnvFollower.h"
-#include "ParameterInterpolator.h"
 
 enum FilterMode
 {
@@ -29,6 +27,8 @@ private:
     FloatArray line_;
     int s_, w_;
     float d_, c_, sr_;
+    float dInc_;
+    int dSteps_;
 
 public:
     Allpass(float sampleRate, int size)
@@ -39,6 +39,8 @@ public:
         w_ = 0;
         d_ = 1.f;
         c_ = 0.7f;
+        dInc_ = 0;
+        dSteps_ = 0;
     }
     ~Allpass()
     {
@@ -58,6 +60,14 @@ public:
     void SetDelay(float d)
     {
         d_ = d;
+        dSteps_ = 0;
+    }
+
+    // Reaches the delay linearly in the given number of samples.
+    void RampDelay(float d, int samples)
+    {
+        dInc_ = (d - d_) / samples;
+        dSteps_ = samples;
     }
 
     void SetC(float c)
@@ -78,6 +88,12 @@ public:
 
     float Process(float in)
     {
+        if (dSteps_ > 0)
+        {
+            d_ += dInc_;
+            dSteps_--;
+        }
+
         size_t idx = (size_t)d_;
         float y0 = readAt(idx);
         float y1 = readAt(idx + 1);
@@ -146,16 +162,30 @@ public:
         delete obj;
     }
 
-    void SetNote(float note)
+    /**
+     * @param note
+     * @param samples Number of samples to glide to the note in, 0 to jump
+     *                to it
+     */
+    void SetNote(float note, int samples = 0)
     {
         // Scale up notes starting from C2.
-        note = Map(note, 14, 127, 36, 127);
+        constexpr Range noteRange(14, 127, 36, 127);
+        note = noteRange.Map(note);
         float d = Clamp(M2D(note), 4.f, 734.f);
 
-        //poles_[0]->SetDelay(d);
-        poles_[1]->SetDelay(d);
-        //poles_[2]->SetDelay(d);
-        poles_[3]->SetDelay(d + d);
+        if (samples == 0)
+        {
+            //poles_[0]->SetDelay(d);
+            poles_[1]->SetDelay(d);
+            //poles_[2]->SetDelay(d);
+            poles_[3]->SetDelay(d + d);
+        }
+        else
+        {
+            poles_[1]->RampDelay(d, samples);
+            poles_[3]->RampDelay(d + d, samples);
+        }
     }
 
     void SetResonance(float reso)
@@ -179,24 +209,133 @@ public:
     }
 };
 
+/**
+ * @brief Stereo state variable filter (Andrew Simper's trapezoidal
+ *        integration version). The exact coefficients are only computed at
+ *        control rate, and are linearly interpolated in between.
+ */
+class RampedSvf
+{
+private:
+    float sampleRate_;
+    float a1_, a2_, a3_, k_;
+    float a1Inc_, a2Inc_, a3Inc_, kInc_;
+    float ic1_[2], ic2_[2];
+
+public:
+    RampedSvf(float sampleRate)
+    {
+        sampleRate_ = sampleRate;
+        a1_ = 1.f;
+        a2_ = a3_ = 0;
+        k_ = 1.f;
+        a1Inc_ = a2Inc_ = a3Inc_ = kInc_ = 0;
+        for (size_t i = 0; i < 2; i++)
+        {
+            ic1_[i] = ic2_[i] = 0;
+        }
+    }
+    ~RampedSvf() {}
+
+    static RampedSvf* create(float sampleRate)
+    {
+        return new RampedSvf(sampleRate);
+    }
+
+    static void destroy(RampedSvf* obj)
+    {
+        delete obj;
+    }
+
+    /**
+     * @brief Computes the exact coefficients for the cutoff, that will be
+     *        reached after the given number of samples, or right away if
+     *        samples is 0.
+     */
+    void SetCutoff(float cutoff, float q, int samples)
+    {
+        float g = tanf(kPi * cutoff / sampleRate_);
+        float k = 1.f / q;
+        float a1 = 1.f / (1.f + g * (g + k));
+        float a2 = g * a1;
+        float a3 = g * a2;
+
+        if (samples == 0)
+        {
+            a1_ = a1;
+            a2_ = a2;
+            a3_ = a3;
+            k_ = k;
+            a1Inc_ = a2Inc_ = a3Inc_ = kInc_ = 0;
+        }
+        else
+        {
+            float r = 1.f / samples;
+            a1Inc_ = (a1 - a1_) * r;
+            a2Inc_ = (a2 - a2_) * r;
+            a3Inc_ = (a3 - a3_) * r;
+            kInc_ = (k - k_) * r;
+        }
+    }
+
+    // The mode only selects the output tap.
+    template <FilterMode mode>
+    inline void Process(float &left, float &right)
+    {
+        a1_ += a1Inc_;
+        a2_ += a2Inc_;
+        a3_ += a3Inc_;
+        k_ += kInc_;
+
+        left = Process<mode>(left, LEFT_CHANNEL);
+        right = Process<mode>(right, RIGHT_CHANNEL);
+    }
+
+private:
+    template <FilterMode mode>
+    inline float Process(float in, int channel)
+    {
+        float v3 = in - ic2_[channel];
+        float v1 = a1_ * ic1_[channel] + a2_ * v3;
+        float v2 = ic2_[channel] + a2_ * ic1_[channel] + a3_ * v3;
+        ic1_[channel] = 2.f * v1 - ic1_[channel];
+        ic2_[channel] = 2.f * v2 - ic2_[channel];
+
+        if (FilterMode::LP == mode)
+        {
+            return v2;
+        }
+        if (FilterMode::BP == mode)
+        {
+            return v1;
+        }
+
+        return in - k_ * v1 - v2;
+    }
+};
+
 class Filter
 {
 private:
     PatchCtrls* patchCtrls_;
     PatchCvs* patchCvs_;
     PatchState* patchState_;
-    StateVariableFilter* filters_[2];
+    RampedSvf* svf_;
     CombFilter* combs_[2];
     ChaosNoise noise_;
     FilterMode mode_, lastMode_;
     DcBlockingFilter* dc_[2];
-    EnvFollower* ef_[2];
+    EnvFollowerBank<2> ef_;
+
+    FloatArray ins_[2], olds_[2];
+    FloatArray notes_, cutoffs_;
 
     float drive_;
     float cutoff_;
     float reso_, resoValue_;
+    ChangeTracker resoChange_;
     float amp_;
-    float filterGain_;
+    float filterGain_, filterGainInc_;
     float dryWet_;
     float noiseLevel_;
     float feedback_;
@@ -230,55 +369,133 @@ private:
         mode_ = mode;
     }
 
-    void SetNote(float note)
+    /**
+     * @brief Sets up the filter to reach the note in the given number of
+     *        samples, interpolating coefficients and gain in between. With
+     *        0 samples the note is set right away.
+     */
+    template <FilterMode mode>
+    void SetNote(float note, float cutoff, int samples)
     {
-        filterGain_ = kFilterLpGainMin;
+        float gain = kFilterLpGainMin;
+
+        if (FilterMode::LP == mode)
+        {
+            svf_->SetCutoff(cutoff, reso_, samples);
+            // Shut the filter off when the frequency is really low.
+            float g = ExpoRange(0.f, 0.97f, kFilterLpGainMax, kFilterLpGainMin).Map(resoValue_);
+            gain = cutoff <= 15.f ? Range(10.f, 15.f, 0.f, g).Map(cutoff) : g;
+        }
+        else if (FilterMode::BP == mode)
+        {
+            svf_->SetCutoff(cutoff, reso_, samples);
+            gain = ExpoRange(0.f, 0.97f, kFilterBpGainMin, kFilterBpGainMax).Map(resoValue_);
+        }
+        else if (FilterMode::HP == mode)
+        {
+            svf_->SetCutoff(cutoff, reso_, samples);
+            // Shut the filter off when the frequency is really high.
+            float g = ExpoRange(0.f, 0.97f, kFilterHpGainMax, kFilterHpGainMin).Map(resoValue_);
+            gain = cutoff >= 20000.f ? Range(15000, 20000, g, 0.f).Map(cutoff) : g;
+        }
+        else
+        {
+            float r = Clamp(VariableCrossFade(0.4f, 0.85f, resoValue_, 0.85f), 0.f, 1.f);
+            combs_[LEFT_CHANNEL]->SetNote(note, samples);
+            combs_[LEFT_CHANNEL]->SetResonance(r);
+            combs_[RIGHT_CHANNEL]->SetNote(note, samples);
+            combs_[RIGHT_CHANNEL]->SetResonance(r);
+            //gain = MapExpo(resoValue_, 0.f, 1.f, kFilterCombGainMax, kFilterCombGainMin);
+        }
+
+        if (samples == 0)
+        {
+            filterGain_ = gain;
+            filterGainInc_ = 0;
+        }
+        else
+        {
+            filterGainInc_ = (gain - filterGain_) / samples;
+        }
+    }
 
-        float cutoff = Clamp(M2F(note), 10.f, 20000.f);
+    /**
+     * @brief The filtering of one mode, without branches on it. Reads the
+     *        driven input from ins_, the notes and cutoffs of the control
+     *        points from notes_ and cutoffs_.
+     *
+     * @param left
+     * @param right
+     * @param controlRate
+     * @param jump Set the first control point right away instead of gliding
+     *             to it
+     */
+    template <FilterMode mode>
+    void ProcessBlock(FloatArray left, FloatArray right, size_t controlRate, bool jump)
+    {
+        size_t size = left.getSize();
+        size_t countdown = 0;
 
-        switch (mode_)
+        for (size_t i = 0; i < size; i++)
         {
-        case FilterMode::LP:
+            if (countdown == 0)
             {
-                filters_[LEFT_CHANNEL]->setLowPass(cutoff, reso_);
-                filters_[RIGHT_CHANNEL]->setLowPass(cutoff, reso_);
-                // Shut the filter off when the frequency is really low.
-                float g = MapExpo(resoValue_, 0.f, 0.97f, kFilterLpGainMax, kFilterLpGainMin);
-                filterGain_ = cutoff <= 15.f ? Map(cutoff, 10.f, 15.f, 0.f, g) : g;
-                break;
+                countdown = size - i < controlRate ? size - i : controlRate;
+                SetNote<mode>(notes_[i], cutoffs_[i], jump && i == 0 ? 0 : countdown);
             }
-        case FilterMode::BP:
+            countdown--;
+            filterGain_ += filterGainInc_;
+
+            float lo = ins_[LEFT_CHANNEL][i];
+            float ro = ins_[RIGHT_CHANNEL][i];
+
+            if (FilterMode::CF == mode)
             {
-                filters_[LEFT_CHANNEL]->setBandPass(cutoff, reso_);
-                filters_[RIGHT_CHANNEL]->setBandPass(cutoff, reso_);
-                filterGain_ = MapExpo(resoValue_, 0.f, 0.97f, kFilterBpGainMin, kFilterBpGainMax);
+                lo = HardClip(combs_[LEFT_CHANNEL]->Process(lo) * filterGain_);
+                ro = HardClip(combs_[RIGHT_CHANNEL]->Process(ro) * filterGain_);
+                lo = dc_[LEFT_CHANNEL]->process(lo);
+                ro = dc_[RIGHT_CHANNEL]->process(ro);
             }
-            break;
-        case FilterMode::HP:
+            else
             {
-                filters_[LEFT_CHANNEL]->setHighPass(cutoff, reso_);
-                filters_[RIGHT_CHANNEL]->setHighPass(cutoff, reso_);
-                // Shut the filter off when the frequency is really high.
-                float g = MapExpo(resoValue_, 0.f, 0.97f, kFilterHpGainMax, kFilterHpGainMin);
-                filterGain_ = cutoff >= 20000.f ? Map(cutoff, 15000, 20000, g, 0.f) : g;
-                break;
+                svf_->Process<mode>(lo, ro);
+                lo *= filterGain_;
+                ro *= filterGain_;
+                float os[2] = { lo, ro };
+                float envs[2];
+                ef_.process(os, envs);
+                lo *= 1.f - envs[LEFT_CHANNEL];
+                ro *= 1.f - envs[RIGHT_CHANNEL];
             }
+
+            left[i] = lo;
+            right[i] = ro;
+        }
+    }
+
+    void ProcessBlock(FilterMode mode, FloatArray left, FloatArray right, size_t controlRate, bool jump)
+    {
+        switch (mode)
+        {
+        case FilterMode::LP:
+            ProcessBlock<FilterMode::LP>(left, right, controlRate, jump);
+            break;
+        case FilterMode::BP:
+            ProcessBlock<FilterMode::BP>(left, right, controlRate, jump);
+            break;
+        case FilterMode::HP:
+            ProcessBlock<FilterMode::HP>(left, right, controlRate, jump);
+            break;
         case FilterMode::CF:
-            float r = Clamp(VariableCrossFade(0.4f, 0.85f, resoValue_, 0.85f), 0.f, 1.f);
-            combs_[LEFT_CHANNEL]->SetNote(note);
-            combs_[LEFT_CHANNEL]->SetResonance(r);
-            combs_[RIGHT_CHANNEL]->SetNote(note);
-            combs_[RIGHT_CHANNEL]->SetResonance(r);
-            //filterGain_ = MapExpo(resoValue_, 0.f, 1.f, kFilterCombGainMax, kFilterCombGainMin);
+            ProcessBlock<FilterMode::CF>(left, right, controlRate, jump);
             break;
         }
-        noise_.SetFreq(cutoff);
     }
 
     void SetReso(float value)
     {
         resoValue_ = Clamp(value);
-        reso_ = MapExpo(value, 0.f, 0.85f, 0.1f, 30.f);
+        reso_ = ExpoRange(0.f, 0.85f, 0.1f, 30.f).Map(value);
         drive_ = VariableCrossFade(0.f, 0.02f, value, 0.35f, 0.65f);
         noiseLevel_ = VariableCrossFade(0.f, 1.f, value, 0.1f, 0.85f);
     }
@@ -293,27 +510,34 @@ public:
         noise_.Init(patchState_->sampleRate);
         noise_.SetChaos(kFilterChaosNoise);
 
+        svf_ = RampedSvf::create(patchState_->sampleRate);
+        notes_ = FloatArray::create(patchState_->blockSize);
+        cutoffs_ = FloatArray::create(patchState_->blockSize);
         for (size_t i = 0; i < 2; i++)
         {
-            filters_[i] = StateVariableFilter::create(patchState_->sampleRate);
+            ins_[i] = FloatArray::create(patchState_->blockSize);
+            olds_[i] = FloatArray::create(patchState_->blockSize);
             combs_[i] = CombFilter::create(patchState_->sampleRate);
             dc_[i] = DcBlockingFilter::create();
-            ef_[i] = EnvFollower::create();
         }
 
         mode_ = lastMode_ = FilterMode::LP;
         cutoff_ = 60.f;
         amp_ = Db2A(120);
         filterGain_ = 0.f;
+        filterGainInc_ = 0.f;
     }
     ~Filter()
     {
+        RampedSvf::destroy(svf_);
+        FloatArray::destroy(notes_);
+        FloatArray::destroy(cutoffs_);
         for (size_t i = 0; i < 2; i++)
         {
-            StateVariableFilter::destroy(filters_[i]);
+            FloatArray::destroy(ins_[i]);
+            FloatArray::destroy(olds_[i]);
             CombFilter::destroy(combs_[i]);
             DcBlockingFilter::destroy(dc_[i]);
-            EnvFollower::destroy(ef_[i]);
         }
     }
 
@@ -336,6 +560,7 @@ public:
         FloatArray leftOut = output.getSamples(LEFT_CHANNEL);
         FloatArray rightOut = output.getSamples(RIGHT_CHANNEL);
 
+        FilterMode oldMode = mode_;
         SetMode(patchCtrls_->filterMode);
         if (mode_ != lastMode_)
         {
@@ -348,13 +573,28 @@ public:
         }
 
         float r = Modulate(patchCtrls_->filterResonance, patchCtrls_->filterResonanceModAmount, patchState_->modValue, patchCtrls_->filterResonanceCvAmount, patchCvs_->filterResonance, -1.f, 1.f, patchState_->modAttenuverters, patchState_->cvAttenuverters);
-        SetReso(r);
+        if (resoChange_.Changed(r))
+        {
+            SetReso(r);
+        }
 
-        ParameterInterpolator cutoffParam = ParameterInterpolator(&cutoff_, patchCtrls_->filterCutoff, size);
+        // Exact coefficients every controlRate samples, interpolated in
+        // between.
+        size_t controlRate = patchState_->filterControlRate < 1 ? 1 : patchState_->filterControlRate;
+        float cutoffInc = (patchCtrls_->filterCutoff - cutoff_) / size;
+        size_t countdown = 0;
 
+        // Noise and drive don't depend on the mode.
         for (size_t i = 0; i < size; i++)
         {
-            SetNote(cutoffParam.Next());
+            if (countdown == 0)
+            {
+                countdown = size - i < controlRate ? size - i : controlRate;
+                notes_[i] = cutoff_ + cutoffInc * (i + countdown);
+                cutoffs_[i] = Clamp(M2F(notes_[i]), 10.f, 20000.f);
+                noise_.SetFreq(cutoffs_[i]);
+            }
+            countdown--;
 
             float n = noise_.Process() * noiseLevel_;
 
@@ -364,27 +604,53 @@ public:
             float ls = SoftClip(lIn * amp_ + n);
             float rs = SoftClip(rIn * amp_ + n);
 
-            float lf = LinearCrossFade(lIn + n, ls, drive_);
-            float rf = LinearCrossFade(rIn + n, rs, drive_);
+            ins_[LEFT_CHANNEL][i] = LinearCrossFade(lIn + n, ls, drive_);
+            ins_[RIGHT_CHANNEL][i] = LinearCrossFade(rIn + n, rs, drive_);
+        }
 
-            float lo = lf, ro = rf;
-            if (FilterMode::CF == mode_)
-            {
-                lo = HardClip(combs_[LEFT_CHANNEL]->Process(lf) * filterGain_);
-                ro = HardClip(combs_[RIGHT_CHANNEL]->Process(rf) * filterGain_);
-                lo = dc_[LEFT_CHANNEL]->process(lo);
-                ro = dc_[RIGHT_CHANNEL]->process(ro);
-            }
-            else
+        if (oldMode != mode_)
+        {
+            // Run the old mode as well and crossfade to the new one. The SVF
+            // modes share the filter state, so the old one runs on a copy of
+            // it, and the new one picks up from the same point.
+            RampedSvf svf = *svf_;
+            EnvFollowerBank<2> ef = ef_;
+            float gain = filterGain_;
+            float gainInc = filterGainInc_;
+
+            FloatArray lOld = olds_[LEFT_CHANNEL].subArray(0, size);
+            FloatArray rOld = olds_[RIGHT_CHANNEL].subArray(0, size);
+            ProcessBlock(oldMode, lOld, rOld, controlRate, false);
+
+            *svf_ = svf;
+            ef_ = ef;
+            filterGain_ = gain;
+            filterGainInc_ = gainInc;
+
+            // The coefficients of the new mode can be stale, jump to them.
+            ProcessBlock(mode_, leftOut, rightOut, controlRate, true);
+
+            float x = 0;
+            float xi = 1.f / size;
+            for (size_t i = 0; i < size; i++)
             {
-                lo = filters_[LEFT_CHANNEL]->process(lf) * filterGain_;
-                ro = filters_[RIGHT_CHANNEL]->process(rf) * filterGain_;
-                lo *= 1.f - ef_[LEFT_CHANNEL]->process(lo);
-                ro *= 1.f - ef_[RIGHT_CHANNEL]->process(ro);
+                x += xi;
+                leftOut[i] = lOld[i] + (leftOut[i] - lOld[i]) * x;
+                rightOut[i] = rOld[i] + (rightOut[i] - rOld[i]) * x;
             }
+        }
+        else
+        {
+            ProcessBlock(mode_, leftOut, rightOut, controlRate, false);
+        }
 
-            leftOut[i] = SoftClip(lo * kFilterMakeupGain * patchCtrls_->filterVol);
-            rightOut[i] = SoftClip(ro * kFilterMakeupGain * patchCtrls_->filterVol);
+        float gain = kFilterMakeupGain * patchCtrls_->filterVol;
+        for (size_t i = 0; i < size; i++)
+        {
+            leftOut[i] = SoftClip(leftOut[i] * gain);
+            rightOut[i] = SoftClip(rightOut[i] * gain);
         }
+
+        cutoff_ = patchCtrls_->filterCutoff;
     }
 };
\ No newline at end of file
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "Commons.h"
+#include <string.h>
+
+// One half of the symmetric side taps of a 31 taps halfband FIR (Kaiser
+// window, beta 7), from the outermost to the innermost. The center tap is
+// 0.5 and every other tap is zero. Flat to 0.17 * fs, -70dB from 0.33 * fs.
+constexpr int kHalfbandTaps = 8;
+constexpr int kHalfbandLength = kHalfbandTaps * 4 - 1;
+constexpr float kHalfbandCoeffs[kHalfbandTaps] = {
+    -1.258541307e-04f,
+    1.064443005e-03f,
+    -3.772257231e-03f,
+    9.803523147e-03f,
+    -2.159067148e-02f,
+    4.398647161e-02f,
+    -9.308523724e-02f,
+    3.137195823e-01f,
+};
+
+/**
+ * @brief Decimates by 2 with the halfband FIR in polyphase form: the odd
+ *        input samples go through the side taps, the even ones only
+ *        through the center one.
+ */
+class HalfbandDecimator
+{
+private:
+    FloatArray buffer_;
+
+public:
+    HalfbandDecimator(int blockSize)
+    {
+        buffer_ = FloatArray::create(blockSize + kHalfbandLength - 1);
+        buffer_.clear();
+    }
+    ~HalfbandDecimator()
+    {
+        FloatArray::destroy(buffer_);
+    }
+
+    static HalfbandDecimator* create(int blockSize)
+    {
+        return new HalfbandDecimator(blockSize);
+    }
+
+    static void destroy(HalfbandDecimator* obj)
+    {
+        delete obj;
+    }
+
+    /**
+     * @param input Block of an even size
+     * @param output Block of half the size of the input
+     */
+    void Process(FloatArray input, FloatArray output)
+    {
+        size_t size = input.getSize();
+        const int history = kHalfbandLength - 1;
+
+        buffer_.subArray(history, size).copyFrom(input);
+
+        const float* x = buffer_.getData();
+        for (size_t i = 0; i < output.getSize(); i++)
+        {
+            // Newest sample of the window.
+            int p = history + 2 * i + 1;
+            float y = 0.5f * x[p - kHalfbandLength / 2];
+            for (int j = 0; j < kHalfbandTaps; j++)
+            {
+                y += kHalfbandCoeffs[j] * (x[p - 2 * j] + x[p - history + 2 * j]);
+            }
+            output[i] = y;
+        }
+
+        // The two regions overlap with small blocks.
+        memmove(buffer_.getData(), buffer_.getData() + size, history * sizeof(float));
+    }
+};
+
+/**
+ * @brief Interpolates by 2 with the halfband FIR in polyphase form: even
+ *        outputs come from the side taps, odd ones are the input delayed.
+ */
+class HalfbandInterpolator
+{
+private:
+    FloatArray buffer_;
+
+public:
+    HalfbandInterpolator(int blockSize)
+    {
+        buffer_ = FloatArray::create(blockSize / 2 + kHalfbandTaps * 2 - 1);
+        buffer_.clear();
+    }
+    ~HalfbandInterpolator()
+    {
+        FloatArray::destroy(buffer_);
+    }
+
+    static HalfbandInterpolator* create(int blockSize)
+    {
+        return new HalfbandInterpolator(blockSize);
+    }
+
+    static void destroy(HalfbandInterpolator* obj)
+    {
+        delete obj;
+    }
+
+    /**
+     * @param input Block at the lower rate
+     * @param output Block of twice the size of the input
+     */
+    void Process(FloatArray input, FloatArray output)
+    {
+        size_t size = input.getSize();
+        const int history = kHalfbandTaps * 2 - 1;
+
+        buffer_.subArray(history, size).copyFrom(input);
+
+        const float* u = buffer_.getData();
+        for (size_t i = 0; i < size; i++)
+        {
+            int p = history + i;
+            float y = 0;
+            for (int j = 0; j < kHalfbandTaps; j++)
+            {
+                y += kHalfbandCoeffs[j] * (u[p - j] + u[p - history + j]);
+            }
+            // Zero stuffing halves the gain, make it up.
+            output[2 * i] = 2.f * y;
+            output[2 * i + 1] = u[p - kHalfbandTaps + 1];
+        }
+
+        // The two regions overlap with small blocks.
+        memmove(buffer_.getData(), buffer_.getData() + size, history * sizeof(float));
+    }
+};
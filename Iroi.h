@@ -11,6 +11,7 @@
 #include "DcBlockingFilter.h"
 #include "SmoothValue.h"
 #include "Modulation.h"
+#include "Profiler.h"
 
 class Iroi
 {
@@ -29,8 +30,8 @@ private:
     StereoDcBlockingFilter* inputDcFilter_;
     StereoDcBlockingFilter* outputDcFilter_;
 
-    EnvFollower* inEnvFollower_[2];
-    EnvFollower* outEnvFollower_[2];
+    EnvFollowerBank<2> inEnvFollowers_, outEnvFollowers_;
+    FloatArray levels_[2];
 
     FilterPosition filterPosition_, lastFilterPosition_;
 
@@ -47,15 +48,17 @@ public:
         resonator_ = Resonator::create(patchCtrls_, patchCvs_, patchState_);
         echo_ = Echo::create(patchCtrls_, patchCvs_, patchState_);
         ambience_ = Ambience::create(patchCtrls_, patchCvs_, patchState_);
+#ifdef USE_PROFILER
+        patchState_->profiler->SetMemory(PROFILER_STAGE_AMBIENCE, ambience_->GetDiffusersMemory());
+#endif
 
         modulation_ = Modulation::create(patchCtrls_, patchCvs_, patchState_);
 
+        inEnvFollowers_.setLambda(0.9f);
+        outEnvFollowers_.setLambda(0.9f);
         for (size_t i = 0; i < 2; i++)
         {
-            inEnvFollower_[i] = EnvFollower::create();
-            inEnvFollower_[i]->setLambda(0.9f);
-            outEnvFollower_[i] = EnvFollower::create();
-            outEnvFollower_[i]->setLambda(0.9f);
+            levels_[i] = FloatArray::create(patchState_->blockSize);
         }
 
         inputDcFilter_ = StereoDcBlockingFilter::create();
@@ -73,8 +76,7 @@ public:
 
         for (size_t i = 0; i < 2; i++)
         {
-            EnvFollower::destroy(outEnvFollower_[i]);
-            EnvFollower::destroy(inEnvFollower_[i]);
+            FloatArray::destroy(levels_[i]);
         }
     }
 
@@ -95,19 +97,20 @@ public:
             return;
         }
 
-        FloatArray left = buffer.getSamples(LEFT_CHANNEL);
-        FloatArray right = buffer.getSamples(RIGHT_CHANNEL);
+        FloatArray channels[2] = { buffer.getSamples(LEFT_CHANNEL), buffer.getSamples(RIGHT_CHANNEL) };
 
-        const int size = buffer.getSize();
-
-        for (size_t i = 0; i < size; i++)
-        {
-            patchState_->inputLevel[i] = Mix2(inEnvFollower_[0]->process(left[i]), inEnvFollower_[1]->process(right[i]));
-        }
+        PROFILE_BEGIN(patchState_, PROFILER_STAGE_INPUT_LEVEL);
+        inEnvFollowers_.process(channels, levels_);
+        Mix2(levels_[LEFT_CHANNEL], levels_[RIGHT_CHANNEL], patchState_->inputLevel);
+        PROFILE_END(patchState_, PROFILER_STAGE_INPUT_LEVEL);
 
+        PROFILE_BEGIN(patchState_, PROFILER_STAGE_INPUT_DC);
         inputDcFilter_->process(buffer, buffer);
+        PROFILE_END(patchState_, PROFILER_STAGE_INPUT_DC);
 
+        PROFILE_BEGIN(patchState_, PROFILER_STAGE_MODULATION);
         modulation_->Process();
+        PROFILE_END(patchState_, PROFILER_STAGE_MODULATION);
 
         if (patchCtrls_->filterPosition < 0.25f)
         {
@@ -138,31 +141,45 @@ public:
 
         if (FilterPosition::POSITION_1 == filterPosition_)
         {
+            PROFILE_BEGIN(patchState_, PROFILER_STAGE_FILTER);
             filter_->process(buffer, buffer);
+            PROFILE_END(patchState_, PROFILER_STAGE_FILTER);
         }
+        PROFILE_BEGIN(patchState_, PROFILER_STAGE_RESONATOR);
         resonator_->process(buffer, buffer);
+        PROFILE_END(patchState_, PROFILER_STAGE_RESONATOR);
         if (FilterPosition::POSITION_2 == filterPosition_)
         {
+            PROFILE_BEGIN(patchState_, PROFILER_STAGE_FILTER);
             filter_->process(buffer, buffer);
+            PROFILE_END(patchState_, PROFILER_STAGE_FILTER);
         }
+        PROFILE_BEGIN(patchState_, PROFILER_STAGE_ECHO);
         echo_->process(buffer, buffer);
+        PROFILE_END(patchState_, PROFILER_STAGE_ECHO);
         if (FilterPosition::POSITION_3 == filterPosition_)
         {
+            PROFILE_BEGIN(patchState_, PROFILER_STAGE_FILTER);
             filter_->process(buffer, buffer);
+            PROFILE_END(patchState_, PROFILER_STAGE_FILTER);
         }
+        PROFILE_BEGIN(patchState_, PROFILER_STAGE_AMBIENCE);
         ambience_->process(buffer, buffer);
+        PROFILE_END(patchState_, PROFILER_STAGE_AMBIENCE);
         if (FilterPosition::POSITION_4 == filterPosition_)
         {
+            PROFILE_BEGIN(patchState_, PROFILER_STAGE_FILTER);
             filter_->process(buffer, buffer);
+            PROFILE_END(patchState_, PROFILER_STAGE_FILTER);
         }
 
         buffer.multiply(kOutputMakeupGain * patchState_->outLevel);
 
         // Level LED.
-        for (size_t i = 0; i < size; i++)
-        {
-            patchState_->outputLevel[i] = Mix2(outEnvFollower_[0]->process(left[i]), outEnvFollower_[1]->process(right[i]));
-        }
+        PROFILE_BEGIN(patchState_, PROFILER_STAGE_OUTPUT_LEVEL);
+        outEnvFollowers_.process(channels, levels_);
+        Mix2(levels_[LEFT_CHANNEL], levels_[RIGHT_CHANNEL], patchState_->outputLevel);
+        PROFILE_END(patchState_, PROFILER_STAGE_OUTPUT_LEVEL);
     }
 };
 
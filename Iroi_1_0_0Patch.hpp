@@ -5,6 +5,7 @@
 #include "Ui.h"
 #include "Clock.h"
 #include "InputDetector.h"
+#include "Profiler.h"
 
 class Iroi_1_0_0Patch : public Patch {
 private:
@@ -23,6 +24,10 @@ public:
         patchState.sampleRate = getSampleRate();
         patchState.blockRate = getBlockRate();
         patchState.blockSize = getBlockSize();
+        patchState.profiler = NULL;
+#ifdef USE_PROFILER
+        patchState.profiler = Profiler::create();
+#endif
         ui_ = Ui::create(&patchCtrls, &patchCvs, &patchState);
         iroi_ = Iroi::create(&patchCtrls, &patchCvs, &patchState);
         clock_ = Clock::create(&patchCtrls, &patchState);
@@ -34,6 +39,9 @@ public:
         Ui::destroy(ui_);
         Clock::destroy(clock_);
         InputDetector::destroy(inDetec_);
+#ifdef USE_PROFILER
+        Profiler::destroy(patchState.profiler);
+#endif
     }
 
     void buttonChanged(PatchButtonId bid, uint16_t value, uint16_t samples) override
@@ -48,10 +56,21 @@ public:
 
     void processAudio(AudioBuffer& buffer) override
     {
+        PROFILE_BEGIN(&patchState, PROFILER_STAGE_UI);
         ui_->Poll();
+        PROFILE_END(&patchState, PROFILER_STAGE_UI);
+
+        PROFILE_BEGIN(&patchState, PROFILER_STAGE_CLOCK);
         clock_->Process();
+        PROFILE_END(&patchState, PROFILER_STAGE_CLOCK);
+
         //inDetec_->Process(buffer);
         iroi_->Process(buffer);
+
+#ifdef USE_PROFILER
+        patchState.profiler->EndBlock();
+        patchState.profiler->Report(patchState.blockRate);
+#endif
     }
 };
 
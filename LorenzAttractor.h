@@ -15,6 +15,14 @@ private:
     float sampleRate_;
     float x_, y_, z_, a_, b_, c_, t_, s_;
     float xAtt_, yAtt_, zAtt_, max_, min_;
+    Range sRange_, xRange_, yRange_;
+
+    void UpdateRanges()
+    {
+        sRange_ = Range(min_, max_, -xAtt_, xAtt_);
+        xRange_ = Range(-20.f, 50.f, -xAtt_, xAtt_);
+        yRange_ = Range(-20.f, 50.f, -yAtt_, yAtt_);
+    }
 
 public:
     static constexpr float begin_phase = 0;
@@ -28,6 +36,7 @@ public:
         yAtt_ = 0.0328f;
         zAtt_ = 0.0078125f;
         max_ = 0; min_ = 0;
+        UpdateRanges();
 
         setType(LorenzAttractor::Type::TYPE_TORUS);
         setFrequency(1.f);
@@ -56,11 +65,13 @@ public:
     void setXAtt(float att)
     {
         xAtt_ = att;
+        UpdateRanges();
     }
 
     void setYAtt(float att)
     {
         yAtt_ = att;
+        UpdateRanges();
     }
 
     /**
@@ -130,7 +141,7 @@ public:
 
     void setFrequency(float freq)
     {
-        freq = Map(freq, 0.01f, 80.f, 0.01f, 9.5f);
+        freq = Range(0.01f, 80.f, 0.01f, 9.5f).Map(freq);
         t_ = 1.f / (sampleRate_ / Clamp(freq, 0.01f, 9.5f));
     }
 
@@ -149,10 +160,14 @@ public:
     {
         process();
 
-        max_ = Max(max_, x_);
-        min_ = Min(min_, x_);
+        if (x_ > max_ || x_ < min_)
+        {
+            max_ = Max(max_, x_);
+            min_ = Min(min_, x_);
+            UpdateRanges();
+        }
 
-        s_ = Map(x_, min_, max_, -xAtt_, xAtt_);
+        s_ = sRange_.Map(x_);
 
         return s_;
     }
@@ -163,8 +178,8 @@ public:
         {
             process();
 
-            xOut[i] = Map(x_, -20.f, 50.f, -xAtt_, xAtt_);
-            yOut[i] = Map(y_, -20.f, 50.f, -yAtt_, yAtt_);
+            xOut[i] = xRange_.Map(x_);
+            yOut[i] = yRange_.Map(y_);
         }
     }
 };
\ No newline at end of file
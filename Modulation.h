@@ -197,7 +197,7 @@ public:
             reset_ = false;
         }
 
-        float l = MapExpo(patchCtrls_->modLevel);
+        float l = ExpoRange().Map(patchCtrls_->modLevel);
         patchState_->modValue = l > 0.02f ? lfo_->generate() * l : 0;
     }
 };
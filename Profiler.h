@@ -0,0 +1,259 @@
+#pragma once
+
+#include "Commons.h"
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#if !defined(__arm__)
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+enum ProfilerStage
+{
+    PROFILER_STAGE_UI,
+    PROFILER_STAGE_CLOCK,
+    PROFILER_STAGE_INPUT_LEVEL,
+    PROFILER_STAGE_INPUT_DC,
+    PROFILER_STAGE_MODULATION,
+    PROFILER_STAGE_FILTER,
+    PROFILER_STAGE_RESONATOR,
+    PROFILER_STAGE_ECHO,
+    PROFILER_STAGE_AMBIENCE,
+    PROFILER_STAGE_OUTPUT_LEVEL,
+    PROFILER_STAGE_LAST
+};
+
+constexpr int kProfilerWindowBlocks = 512; // Blocks kept for the p99 estimation
+
+/**
+ * @brief Per-stage cycle counter. Each stage is timed once per block between
+ *        Begin() and End(), and EndBlock() folds the block's counts into the
+ *        running statistics.
+ *        Uses the DWT cycle counter on ARM, rdtsc on x86 and clock_gettime
+ *        (nanoseconds) elsewhere.
+ */
+class Profiler
+{
+private:
+    uint32_t start_[PROFILER_STAGE_LAST];
+    uint32_t block_[PROFILER_STAGE_LAST];
+    uint32_t min_[PROFILER_STAGE_LAST];
+    uint32_t max_[PROFILER_STAGE_LAST];
+    uint64_t sum_[PROFILER_STAGE_LAST];
+    uint32_t count_[PROFILER_STAGE_LAST];
+    uint32_t window_[PROFILER_STAGE_LAST][kProfilerWindowBlocks];
+    uint32_t sorted_[kProfilerWindowBlocks];
+    uint32_t memory_[PROFILER_STAGE_LAST];
+    bool active_[PROFILER_STAGE_LAST];
+
+    int reportStage_;
+    int reportSamples_;
+
+#ifdef __arm__
+    static inline volatile uint32_t& DwtCtrl()
+    {
+        return *reinterpret_cast<volatile uint32_t*>(0xE0001000);
+    }
+
+    static inline volatile uint32_t& DwtCycCnt()
+    {
+        return *reinterpret_cast<volatile uint32_t*>(0xE0001004);
+    }
+
+    static inline volatile uint32_t& DemCr()
+    {
+        return *reinterpret_cast<volatile uint32_t*>(0xE000EDFC);
+    }
+#endif
+
+public:
+    Profiler()
+    {
+#ifdef __arm__
+        DemCr() |= (1 << 24); // TRCENA
+        DwtCycCnt() = 0;
+        DwtCtrl() |= 1; // CYCCNTENA
+#endif
+        memset(memory_, 0, sizeof(memory_));
+        Reset();
+    }
+    ~Profiler() {}
+
+    static Profiler* create()
+    {
+        return new Profiler();
+    }
+
+    static void destroy(Profiler* obj)
+    {
+        delete obj;
+    }
+
+    static inline uint32_t Cycles()
+    {
+#if defined(__arm__)
+        return DwtCycCnt();
+#elif defined(__x86_64__) || defined(__i386__)
+        return static_cast<uint32_t>(__rdtsc());
+#else
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        return static_cast<uint32_t>(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+#endif
+    }
+
+    void Reset()
+    {
+        for (int i = 0; i < PROFILER_STAGE_LAST; i++)
+        {
+            start_[i] = 0;
+            block_[i] = 0;
+            min_[i] = UINT32_MAX;
+            max_[i] = 0;
+            sum_[i] = 0;
+            count_[i] = 0;
+            active_[i] = false;
+        }
+        memset(window_, 0, sizeof(window_));
+
+        reportStage_ = 0;
+        reportSamples_ = 0;
+    }
+
+    inline void Begin(ProfilerStage stage)
+    {
+        start_[stage] = Cycles();
+    }
+
+    inline void End(ProfilerStage stage)
+    {
+        // Unsigned difference is safe across a counter wrap.
+        block_[stage] += Cycles() - start_[stage];
+        active_[stage] = true;
+    }
+
+    // Called once at the end of every block.
+    void EndBlock()
+    {
+        for (int i = 0; i < PROFILER_STAGE_LAST; i++)
+        {
+            if (!active_[i])
+            {
+                continue;
+            }
+
+            uint32_t c = block_[i];
+            min_[i] = c < min_[i] ? c : min_[i];
+            max_[i] = c > max_[i] ? c : max_[i];
+            sum_[i] += c;
+            window_[i][count_[i] % kProfilerWindowBlocks] = c;
+            count_[i]++;
+
+            block_[i] = 0;
+            active_[i] = false;
+        }
+    }
+
+    uint32_t GetMin(ProfilerStage stage)
+    {
+        return count_[stage] == 0 ? 0 : min_[stage];
+    }
+
+    uint32_t GetMax(ProfilerStage stage)
+    {
+        return max_[stage];
+    }
+
+    uint32_t GetMean(ProfilerStage stage)
+    {
+        return count_[stage] == 0 ? 0 : sum_[stage] / count_[stage];
+    }
+
+    // 99th percentile over the last kProfilerWindowBlocks blocks.
+    uint32_t GetP99(ProfilerStage stage)
+    {
+        int n = count_[stage] < kProfilerWindowBlocks ? count_[stage] : kProfilerWindowBlocks;
+        if (n == 0)
+        {
+            return 0;
+        }
+
+        memcpy(sorted_, window_[stage], n * sizeof(uint32_t));
+        int k = (n * 99) / 100;
+        std::nth_element(sorted_, sorted_ + k, sorted_ + n);
+
+        return sorted_[k];
+    }
+
+    /**
+     * @brief Sets the memory (in bytes) a stage allocated, to be reported
+     *        along with its cycles. Not cleared by Reset().
+     */
+    void SetMemory(ProfilerStage stage, uint32_t bytes)
+    {
+        memory_[stage] = bytes;
+    }
+
+    uint32_t GetMemory(ProfilerStage stage)
+    {
+        return memory_[stage];
+    }
+
+    /**
+     * @brief Sends one entry per second to the debug message line, cycling
+     *        through the mean, p99 and max cycles of every stage, then their
+     *        min, then the memory of the stages that set one.
+     *
+     * @param blockRate
+     */
+    void Report(float blockRate)
+    {
+        if (++reportSamples_ < blockRate)
+        {
+            return;
+        }
+        reportSamples_ = 0;
+
+        static const char* names[PROFILER_STAGE_LAST] = {
+            "ui", "clk", "inlvl", "indc", "mod", "flt", "res", "echo", "amb", "outlvl"
+        };
+        static const char* minNames[PROFILER_STAGE_LAST] = {
+            "ui min", "clk min", "inlvl min", "indc min", "mod min", "flt min", "res min", "echo min", "amb min", "outlvl min"
+        };
+
+        // The last entries are the memory ones, skip those that weren't set.
+        while (reportStage_ >= 2 * PROFILER_STAGE_LAST && memory_[reportStage_ - 2 * PROFILER_STAGE_LAST] == 0)
+        {
+            reportStage_ = (reportStage_ + 1) % (3 * PROFILER_STAGE_LAST);
+        }
+
+        ProfilerStage s = ProfilerStage(reportStage_ % PROFILER_STAGE_LAST);
+        if (reportStage_ < PROFILER_STAGE_LAST)
+        {
+            debugMessage(names[s], (int)GetMean(s), (int)GetP99(s), (int)GetMax(s));
+        }
+        else if (reportStage_ < 2 * PROFILER_STAGE_LAST)
+        {
+            debugMessage(minNames[s], (int)GetMin(s));
+        }
+        else
+        {
+            debugMessage(names[s], (int)GetMemory(s));
+        }
+
+        reportStage_ = (reportStage_ + 1) % (3 * PROFILER_STAGE_LAST);
+    }
+};
+
+#ifdef USE_PROFILER
+#define PROFILE_BEGIN(state, stage) (state)->profiler->Begin(stage)
+#define PROFILE_END(state, stage) (state)->profiler->End(stage)
+#else
+#define PROFILE_BEGIN(state, stage)
+#define PROFILE_END(state, stage)
+#endif
@@ -1,165 +1,361 @@
 #pragma once
 
 #include "Commons.h"
-#include "DelayLine.h"
 #include "BiquadFilter.h"
 #include "EnvFollower.h"
-#include "DcBlockingFilter.h"
 #include "Compressor.h"
 
-class Pole
+/**
+ * @brief Precomputed pole tuning, so that retuning doesn't need any
+ *        transcendental call: delay time and low pass frequency by fractional
+ *        note, and the bilinear prewarping of the low pass cutoff by
+ *        frequency.
+ *        Both note values are exponential, so they are stored by whole note
+ *        and multiplied by the ratio of the fractional part, which is
+ *        linearly interpolated on a 1/256 note grid. Interpolating the values
+ *        themselves would need a far larger table for the same accuracy.
+ */
+class PoleTable
 {
-public:
-    Pole(float sampleRate)
-    {
-        sampleRate_ = sampleRate;
-        msr_ = sampleRate_ / 1000.f;
+private:
+    float delays_[kResoTableSize];
+    float freqs_[kResoTableSize];
+    float delayRatios_[kResoTableFracSize];
+    float freqRatios_[kResoTableFracSize];
+    float prewarps_[kResoTableFreqSize];
 
-        for (size_t i = 0; i < 2; i++)
+    static float Interpolate(const float* table, int size, float pos)
+    {
+        pos = Clamp(pos, 0.f, size - 1);
+        int i = pos;
+        if (i > size - 2)
         {
-            delays_[i] = DelayLine::create(kResoBufferSize);
-            lpfs_[i] = BiquadFilter::create(sampleRate_);
-            dc_[i] = DcBlockingFilter::create();
-            ef_[i] = EnvFollower::create();
+            i = size - 2;
         }
+        float frac = pos - i;
 
-        reso_ = FilterStage::BUTTERWORTH_Q;
-        offset_ = 0;
-        feedback_ = 0;
-        filter_ = 0;
-        detune_ = 0;
-        infinite_ = false;
+        return table[i] + (table[i + 1] - table[i]) * frac;
     }
-    ~Pole()
+
+public:
+    PoleTable(float sampleRate)
     {
-        for (size_t i = 0; i < 2; i++)
+        float msr = sampleRate / 1000.f;
+        for (int i = 0; i < kResoTableSize; i++)
+        {
+            float note = kResoTableMinNote + i;
+            delays_[i] = msr * Db2A(note);
+            freqs_[i] = M2F(note);
+        }
+        for (int i = 0; i < kResoTableFracSize; i++)
+        {
+            float frac = i / (float)kResoTableStepsPerNote;
+            delayRatios_[i] = Db2A(frac);
+            freqRatios_[i] = Power(2.f, frac / kSemi4Oct);
+        }
+        for (int i = 0; i < kResoTableFreqSize; i++)
         {
-            DelayLine::destroy(delays_[i]);
-            BiquadFilter::destroy(lpfs_[i]);
-            DcBlockingFilter::destroy(dc_[i]);
-            EnvFollower::destroy(ef_[i]);
+            prewarps_[i] = tanf(M_PI * i * kResoTableFreqStep / sampleRate);
         }
     }
+    ~PoleTable() {}
 
-    static Pole* create(float sampleRate)
+    static PoleTable* create(float sampleRate)
     {
-        return new Pole(sampleRate);
+        return new PoleTable(sampleRate);
     }
 
-    static void destroy(Pole* pole)
+    static void destroy(PoleTable* table)
     {
-        delete pole;
+        delete table;
     }
 
-    float GetSemiOffset()
+    /**
+     * @brief Delay time in samples (msr * Db2A(note)) and frequency
+     *        (M2F(note)) of a note.
+     */
+    inline void GetNote(float note, float &delay, float &freq) const
     {
-        return offset_;
+        float pos = Clamp(note - kResoTableMinNote, 0.f, kResoTableSize - 1);
+        int i = pos;
+        float frac = (pos - i) * kResoTableStepsPerNote;
+        delay = delays_[i] * Interpolate(delayRatios_, kResoTableFracSize, frac);
+        freq = freqs_[i] * Interpolate(freqRatios_, kResoTableFracSize, frac);
     }
 
     /**
-     * @param offset Semitones, -24 to 24
+     * @brief tan(pi * freq / sampleRate), as used by the bilinear transform.
      */
-    void SetSemiOffset(float offset)
+    inline float GetPrewarp(float freq) const
     {
-        offset_ = offset * -0.5f + 17.667f;
-        SetNote();
+        return Interpolate(prewarps_, kResoTableFreqSize, freq * (1.f / kResoTableFreqStep));
     }
+};
 
-    void SetFilter(float filter)
+// Only the left channel of the second pole and the right channel of the
+// third one are heard, so they're the only ones processed.
+enum ResoLane
+{
+    RESO_LANE_POLE_0_LEFT,
+    RESO_LANE_POLE_0_RIGHT,
+    RESO_LANE_POLE_1_LEFT,
+    RESO_LANE_POLE_2_RIGHT,
+    RESO_LANE_LAST
+};
+
+/**
+ * @brief The feedback combs of the three poles, as a structure of arrays
+ *        with one lane per comb, so that each stage runs over all the lanes
+ *        in a single loop. The delay lines are interleaved in one buffer:
+ *        each write stores one frame with a sample per lane.
+ */
+class CombBank
+{
+private:
+    FloatArray buffer_;
+    uint32_t size_, mask_, writeIndex_;
+
+    // Feedback loop.
+    alignas(16) float delayTimes_[RESO_LANE_LAST];
+    alignas(16) float outs_[RESO_LANE_LAST];
+    alignas(16) float mix_[RESO_LANE_LAST];
+
+    // Low pass, transposed direct form II.
+    alignas(16) float b0_[RESO_LANE_LAST];
+    alignas(16) float b1_[RESO_LANE_LAST];
+    alignas(16) float a1_[RESO_LANE_LAST];
+    alignas(16) float a2_[RESO_LANE_LAST];
+    alignas(16) float z1_[RESO_LANE_LAST];
+    alignas(16) float z2_[RESO_LANE_LAST];
+
+    // DC blocker.
+    alignas(16) float dcIns_[RESO_LANE_LAST];
+    alignas(16) float dcOuts_[RESO_LANE_LAST];
+
+    // Envelope follower, only running with infinite feedback.
+    alignas(16) float efs_[RESO_LANE_LAST];
+
+    float feedback_;
+    bool infinite_;
+
+public:
+    CombBank()
     {
-        filter_ = filter;
-        SetFreq();
+        size_ = NextPowerOfTwo(kResoLineSize);
+        mask_ = size_ - 1;
+        buffer_ = FloatArray::create(size_ * RESO_LANE_LAST);
+        buffer_.clear();
+        writeIndex_ = 0;
+
+        for (int i = 0; i < RESO_LANE_LAST; i++)
+        {
+            delayTimes_[i] = 0;
+            outs_[i] = 0;
+            mix_[i] = 0;
+            b0_[i] = 1.f;
+            b1_[i] = a1_[i] = a2_[i] = 0;
+            z1_[i] = z2_[i] = 0;
+            dcIns_[i] = dcOuts_[i] = 0;
+            efs_[i] = 0;
+        }
+
+        feedback_ = 0;
+        infinite_ = false;
+    }
+    ~CombBank()
+    {
+        FloatArray::destroy(buffer_);
     }
 
-    void SetFeedback(float feedback)
+    static CombBank* create()
     {
-        infinite_ = feedback > kResoInfiniteFeedbackThreshold;
-        feedback_ = VariableCrossFade(0.f, 1.f, feedback, kResoInfiniteFeedbackThreshold - 0.01f);
+        return new CombBank();
     }
 
-    void SetDissonance(float detune)
+    static void destroy(CombBank* bank)
     {
-        detune_ = detune;
-        SetNote();
+        delete bank;
     }
 
-    void SetReso(float reso)
+    void SetDelay(int lane, float delay)
     {
-        reso_ = reso;
-        SetFreq();
+        delayTimes_[lane] = Clamp(delay, 0, kResoBufferSize);
     }
 
-    // Process just one of the two channels.
-    float Process(float in, int channel)
+    /**
+     * @param lane
+     * @param k Prewarped cutoff, see PoleTable::GetPrewarp()
+     * @param rq 1 / Q
+     */
+    void SetLowPass(int lane, float k, float rq)
+    {
+        float kk = k * k;
+        float kq = k * rq;
+        float norm = 1.f / (1.f + kq + kk);
+        b0_[lane] = kk * norm;
+        b1_[lane] = 2.f * b0_[lane];
+        a1_[lane] = 2.f * (kk - 1.f) * norm;
+        a2_[lane] = (1.f - kq + kk) * norm;
+    }
+
+    void SetFeedback(float feedback)
+    {
+        infinite_ = feedback > kResoInfiniteFeedbackThreshold;
+        feedback_ = VariableCrossFade(0.f, 1.f, feedback, kResoInfiniteFeedbackThreshold - 0.01f);
+    }
+
+    /**
+     * @brief Runs one sample through all the lanes.
+     *
+     * @param in RESO_LANE_LAST inputs
+     * @param out RESO_LANE_LAST outputs
+     */
+    void Process(const float* in, float* out)
     {
-        float out = lpfs_[channel]->process(outs_[channel]) * feedback_;
+        for (int i = 0; i < RESO_LANE_LAST; i++)
+        {
+            float y = b0_[i] * outs_[i] + z1_[i];
+            z1_[i] = b1_[i] * outs_[i] - a1_[i] * y + z2_[i];
+            z2_[i] = b0_[i] * outs_[i] - a2_[i] * y;
+            out[i] = y * feedback_;
+        }
 
-        float mix = HardClip(dc_[channel]->process(in + out));
+        for (int i = 0; i < RESO_LANE_LAST; i++)
+        {
+            float x = in[i] + out[i];
+            dcOuts_[i] = x - dcIns_[i] + kResoDcLambda * dcOuts_[i];
+            dcIns_[i] = x;
+            mix_[i] = HardClip(dcOuts_[i]);
+        }
 
         // Handle infinite feedback.
         if (infinite_)
         {
-            mix *= feedback_ * kResoInfiniteFeedbackLevel - ef_[channel]->process(mix);
+            for (int i = 0; i < RESO_LANE_LAST; i++)
+            {
+                efs_[i] = efs_[i] * kResoEfLambda + fabsf(mix_[i]) * (1.f - kResoEfLambda);
+                mix_[i] *= feedback_ * kResoInfiniteFeedbackLevel - Clamp(efs_[i]);
+            }
         }
 
-        delays_[channel]->write(mix);
-        outs_[channel] = delays_[channel]->read(delayTimes_[channel]);
+        float* frame = buffer_.getData() + writeIndex_ * RESO_LANE_LAST;
+        for (int i = 0; i < RESO_LANE_LAST; i++)
+        {
+            frame[i] = Clamp(mix_[i], -3.f, 3.f);
+        }
+        writeIndex_ = (writeIndex_ + 1) & mask_;
 
-        return out;
+        float* data = buffer_.getData();
+        for (int i = 0; i < RESO_LANE_LAST; i++)
+        {
+            uint32_t idx = (uint32_t)delayTimes_[i];
+            float frac = delayTimes_[i] - idx;
+            float y0 = data[((writeIndex_ - idx - 1) & mask_) * RESO_LANE_LAST + i];
+            float y1 = data[((writeIndex_ - idx - 2) & mask_) * RESO_LANE_LAST + i];
+            outs_[i] = y0 + frac * (y1 - y0);
+        }
     }
+};
 
-    void Process(float leftIn, float rightIn, float &leftOut, float &rightOut)
+/**
+ * @brief Tuning of a pair of lanes of the comb bank. A lane can be -1 if
+ *        the pole doesn't use that channel.
+ */
+class Pole
+{
+public:
+    Pole(const PoleTable* table, CombBank* bank, int leftLane, int rightLane)
     {
-        leftOut = lpfs_[LEFT_CHANNEL]->process(outs_[LEFT_CHANNEL]) * feedback_;
-        rightOut = lpfs_[RIGHT_CHANNEL]->process(outs_[RIGHT_CHANNEL]) * feedback_;
+        table_ = table;
+        bank_ = bank;
+        lanes_[LEFT_CHANNEL] = leftLane;
+        lanes_[RIGHT_CHANNEL] = rightLane;
 
-        float leftMix = HardClip(dc_[LEFT_CHANNEL]->process(leftIn + leftOut));
-        float rightMix = HardClip(dc_[RIGHT_CHANNEL]->process(rightIn + rightOut));
+        rq_ = 1.f / FilterStage::BUTTERWORTH_Q;
+        offset_ = 0;
+        filter_ = 0;
+        detune_ = 0;
+        freqs_[LEFT_CHANNEL] = freqs_[RIGHT_CHANNEL] = 0;
+    }
+    ~Pole() {}
 
-        // Handle infinite feedback.
-        if (infinite_)
-        {
-            leftMix *= feedback_ * kResoInfiniteFeedbackLevel - ef_[LEFT_CHANNEL]->process(leftMix);
-            rightMix *= feedback_ * kResoInfiniteFeedbackLevel - ef_[RIGHT_CHANNEL]->process(rightMix);
-        }
+    static Pole* create(const PoleTable* table, CombBank* bank, int leftLane, int rightLane)
+    {
+        return new Pole(table, bank, leftLane, rightLane);
+    }
+
+    static void destroy(Pole* pole)
+    {
+        delete pole;
+    }
+
+    float GetSemiOffset()
+    {
+        return offset_;
+    }
+
+    /**
+     * @param offset Semitones, -24 to 24
+     */
+    void SetSemiOffset(float offset)
+    {
+        offset_ = offset * -0.5f + 17.667f;
+        SetNote();
+    }
+
+    void SetFilter(float filter)
+    {
+        filter_ = filter;
+        SetFreq();
+    }
 
-        delays_[LEFT_CHANNEL]->write(leftMix);
-        delays_[RIGHT_CHANNEL]->write(rightMix);
+    void SetDissonance(float detune)
+    {
+        detune_ = detune;
+        SetNote();
+    }
 
-        outs_[LEFT_CHANNEL] = delays_[LEFT_CHANNEL]->read(delayTimes_[LEFT_CHANNEL]);
-        outs_[RIGHT_CHANNEL] = delays_[RIGHT_CHANNEL]->read(delayTimes_[RIGHT_CHANNEL]);
+    void SetReso(float reso)
+    {
+        rq_ = 1.f / reso;
+        SetFreq();
     }
 
 private:
-    DelayLine *delays_[2];
-    BiquadFilter *lpfs_[2];
-    EnvFollower *ef_[2];
-    DcBlockingFilter* dc_[2];
-    float delayTimes_[2], outs_[2];
-
-    float sampleRate_, msr_;
-    float lf_, rf_;
-    float reso_;
+    const PoleTable* table_;
+    CombBank* bank_;
+    int lanes_[2];
+
+    float freqs_[2];
+    float rq_;
     float offset_;
-    float feedback_;
     float filter_;
     float detune_;
 
-    bool infinite_;
-
     void SetFreq()
     {
-        lpfs_[LEFT_CHANNEL]->setLowPass(M2F(lf_) + filter_, reso_);
-        lpfs_[RIGHT_CHANNEL]->setLowPass(M2F(rf_) + filter_, reso_);
+        for (int i = 0; i < 2; i++)
+        {
+            if (lanes_[i] >= 0)
+            {
+                bank_->SetLowPass(lanes_[i], table_->GetPrewarp(freqs_[i] + filter_), rq_);
+            }
+        }
     }
 
     void SetNote()
     {
-        lf_ = offset_ + detune_;
-        rf_ = offset_ - detune_;
+        float notes[2] = { offset_ + detune_, offset_ - detune_ };
 
-        delayTimes_[LEFT_CHANNEL] = Clamp(msr_ * Db2A(lf_), 0, kResoBufferSize);
-        delayTimes_[RIGHT_CHANNEL] = Clamp(msr_ * Db2A(rf_), 0, kResoBufferSize);
+        for (int i = 0; i < 2; i++)
+        {
+            if (lanes_[i] >= 0)
+            {
+                float delay;
+                table_->GetNote(notes[i], delay, freqs_[i]);
+                bank_->SetDelay(lanes_[i], delay);
+            }
+        }
 
         SetFreq();
     }
@@ -176,13 +372,18 @@ private:
     PatchCtrls* patchCtrls_;
     PatchCvs* patchCvs_;
     PatchState* patchState_;
+    PoleTable* poleTable_;
+    CombBank* combs_;
     Pole* poles_[3];
 
     BiquadFilter *notches_[2];
     BiquadFilter *hs_[2];
-    EnvFollower *ef_[2];
+    EnvFollowerBank<2> ef_;
 
     Compressor* compressor_;
+    EqualPowerCrossFader crossFader_;
+
+    FloatArray wets_[2];
 
     float amp_;
     float dryWet_;
@@ -190,9 +391,12 @@ private:
     float tune_;
     float oldTuning_;
     int ranges_[3];
+    Range tuneRanges_[6];
 
     int task_;
 
+    ChangeTracker dissonanceChange_, feedbackChange_;
+
     /**
      * @param idx 0 - 3
      * @param offset -24/24
@@ -224,39 +428,39 @@ private:
         task_ = (task_ + 1) % 6;
         if (task_ == 0)
         {
-            SetSemiOffset(0, Map(tune_, 0.f, 1.f, -24, ranges_[0]));
+            SetSemiOffset(0, tuneRanges_[0].Map(tune_));
         }
         if (tune_ < 0.5f && task_ == 1)
         {
-            SetSemiOffset(1, Map(tune_, 0.f, 0.5f, -12, ranges_[1]));
+            SetSemiOffset(1, tuneRanges_[1].Map(tune_));
         }
         if (tune_ < 0.3f && task_ == 2)
         {
-            SetSemiOffset(2, Map(tune_, 0.f, 0.3f, -6, ranges_[2]));
+            SetSemiOffset(2, tuneRanges_[2].Map(tune_));
         }
         if (tune_ >= 0.3f && tune_ < 0.7f && task_ == 3)
         {
-            SetSemiOffset(2, Map(tune_, 0.3f, 0.7f, -6, ranges_[2]));
+            SetSemiOffset(2, tuneRanges_[3].Map(tune_));
         }
         if (tune_ >= 0.5f && task_ == 4)
         {
-            SetSemiOffset(1, Map(tune_, 0.5f, 1.f, -12, ranges_[1]));
+            SetSemiOffset(1, tuneRanges_[4].Map(tune_));
         }
         if (tune_ >= 0.7f && task_ == 5)
         {
-            SetSemiOffset(2, Map(tune_, 0.7f, 1.f, -6, ranges_[2]));
+            SetSemiOffset(2, tuneRanges_[5].Map(tune_));
         }
     }
 
     void SetFeedback(float value, bool init = false)
     {
-        float feedback = Map(value, 0.f, 1.f, 0.85f, 1.f);
-        float reso = Map(value, 0.f, 1.f, 0.5f, 0.6f);
-        float filter = Map(value, 0.f, 1.f, 5000.f, 10000.f);
+        float feedback = Range(0.f, 1.f, 0.85f, 1.f).Map(value);
+        float reso = Range(0.f, 1.f, 0.5f, 0.6f).Map(value);
+        float filter = Range(0.f, 1.f, 5000.f, 10000.f).Map(value);
         //amp_ = Map(value, 0.f, 1.f, kResoGainMax, kResoGainMin) * 0.577f;
+        combs_->SetFeedback(feedback);
         for (int i = 0; i < 3; i++)
         {
-            poles_[i]->SetFeedback(feedback);
             poles_[i]->SetReso(reso);
             poles_[i]->SetFilter(filter);
         }
@@ -265,15 +469,23 @@ private:
     /*
     void SetRange(float range)
     {
-        range_ = Map(range, 0.f, kOne, 0.1f, 1.f);
+        range_ = Range(0.f, kOne, 0.1f, 1.f).Map(range);
     }
     */
 
     void SetDissonance(float value)
     {
-        ranges_[0] = Map(value, 0.f, 1.f, 24, 16);
-        ranges_[1] = Map(value, 0.f, 1.f, 12, 7);
-        ranges_[2] = Map(value, 0.f, 1.f, 6, 13);
+        ranges_[0] = Range(0.f, 1.f, 24, 16).Map(value);
+        ranges_[1] = Range(0.f, 1.f, 12, 7).Map(value);
+        ranges_[2] = Range(0.f, 1.f, 6, 13).Map(value);
+
+        // The tune mappings of each task of SetTune().
+        tuneRanges_[0] = Range(0.f, 1.f, -24, ranges_[0]);
+        tuneRanges_[1] = Range(0.f, 0.5f, -12, ranges_[1]);
+        tuneRanges_[2] = Range(0.f, 0.3f, -6, ranges_[2]);
+        tuneRanges_[3] = Range(0.3f, 0.7f, -6, ranges_[2]);
+        tuneRanges_[4] = Range(0.5f, 1.f, -12, ranges_[1]);
+        tuneRanges_[5] = Range(0.7f, 1.f, -6, ranges_[2]);
 
         poles_[0]->SetDissonance(value);
         poles_[1]->SetDissonance(value * 2.f);
@@ -287,10 +499,11 @@ public:
         patchCvs_ = patchCvs;
         patchState_ = patchState;
 
-        for (int i = 0; i < 3; i++)
-        {
-            poles_[i] = Pole::create(patchState_->sampleRate);
-        }
+        poleTable_ = PoleTable::create(patchState_->sampleRate);
+        combs_ = CombBank::create();
+        poles_[0] = Pole::create(poleTable_, combs_, RESO_LANE_POLE_0_LEFT, RESO_LANE_POLE_0_RIGHT);
+        poles_[1] = Pole::create(poleTable_, combs_, RESO_LANE_POLE_1_LEFT, -1);
+        poles_[2] = Pole::create(poleTable_, combs_, -1, RESO_LANE_POLE_2_RIGHT);
 
         for (size_t i = 0; i < 2; i++)
         {
@@ -298,7 +511,7 @@ public:
             notches_[i]->setNotch(8000.f, FilterStage::SALLEN_KEY_Q);
             hs_[i] = BiquadFilter::create(patchState_->sampleRate);
             hs_[i]->setHighShelf(8000.f, -24.f);
-            ef_[i] = EnvFollower::create();
+            wets_[i] = FloatArray::create(patchState_->blockSize);
         }
 
         compressor_ = Compressor::create(patchState_->sampleRate);
@@ -319,11 +532,13 @@ public:
         {
             Pole::destroy(poles_[i]);
         }
+        CombBank::destroy(combs_);
+        PoleTable::destroy(poleTable_);
         for (size_t i = 0; i < 2; i++)
         {
             BiquadFilter::destroy(notches_[i]);
             BiquadFilter::destroy(hs_[i]);
-            EnvFollower::destroy(ef_[i]);
+            FloatArray::destroy(wets_[i]);
         }
 
         Compressor::destroy(compressor_);
@@ -347,13 +562,19 @@ public:
         FloatArray leftOut = output.getSamples(LEFT_CHANNEL);
         FloatArray rightOut = output.getSamples(RIGHT_CHANNEL);
 
-        SetDissonance(patchCtrls_->resonatorDissonance);
+        if (dissonanceChange_.Changed(patchCtrls_->resonatorDissonance))
+        {
+            SetDissonance(dissonanceChange_.Get());
+        }
 
         float t = Modulate(patchCtrls_->resonatorTune, patchCtrls_->resonatorTuneModAmount, patchState_->modValue, patchCtrls_->resonatorTuneCvAmount, patchCvs_->resonatorTune, -1.f, 1.f, patchState_->modAttenuverters, patchState_->cvAttenuverters);
         ParameterInterpolator tuningParam(&oldTuning_, t, size);
 
         float f = Modulate(patchCtrls_->resonatorFeedback, patchCtrls_->resonatorFeedbackModAmount, patchState_->modValue, patchCtrls_->resonatorFeedbackCvAmount, patchCvs_->resonatorFeedback, -1.f, 1.f, patchState_->modAttenuverters, patchState_->cvAttenuverters);
-        SetFeedback(f);
+        if (feedbackChange_.Changed(f))
+        {
+            SetFeedback(f);
+        }
 
         for (size_t i = 0; i < size; i++)
         {
@@ -362,20 +583,24 @@ public:
             float lIn = Clamp(leftIn[i], -3.f, 3.f);
             float rIn = Clamp(rightIn[i], -3.f, 3.f);
 
-            float left = poles_[1]->Process(lIn, LEFT_CHANNEL);
-            float right = poles_[2]->Process(rIn, RIGHT_CHANNEL);
+            float ins[RESO_LANE_LAST] = { lIn, rIn, lIn, rIn };
+            float outs[RESO_LANE_LAST];
+            combs_->Process(ins, outs);
+
+            float left = outs[RESO_LANE_POLE_1_LEFT];
+            float right = outs[RESO_LANE_POLE_2_RIGHT];
 
             float oLeft = left * 0.75f + right * 0.25f;
             float oRight = left * 0.25f + right * 0.75f;
 
-            left = 0;
-            right = 0;
-            poles_[0]->Process(lIn, rIn, left, right);
-            oLeft += left;
-            oRight += right;
+            oLeft += outs[RESO_LANE_POLE_0_LEFT];
+            oRight += outs[RESO_LANE_POLE_0_RIGHT];
 
-            oLeft *= 1.f - ef_[LEFT_CHANNEL]->process(oLeft);
-            oRight *= 1.f - ef_[RIGHT_CHANNEL]->process(oRight);
+            float os[2] = { oLeft, oRight };
+            float envs[2];
+            ef_.process(os, envs);
+            oLeft *= 1.f - envs[LEFT_CHANNEL];
+            oRight *= 1.f - envs[RIGHT_CHANNEL];
 
             oLeft *= amp_;
             oRight *= amp_;
@@ -386,10 +611,18 @@ public:
             oLeft = hs_[LEFT_CHANNEL]->process(oLeft);
             oRight = hs_[RIGHT_CHANNEL]->process(oRight);
 
-            leftOut[i] = CheapEqualPowerCrossFade(lIn, oLeft * kResoMakeupGain, patchCtrls_->resonatorVol);
-            rightOut[i] = CheapEqualPowerCrossFade(rIn, oRight * kResoMakeupGain, patchCtrls_->resonatorVol);
+            wets_[LEFT_CHANNEL][i] = oLeft * kResoMakeupGain;
+            wets_[RIGHT_CHANNEL][i] = oRight * kResoMakeupGain;
+
+            // The output holds the dry signal until the crossfade.
+            leftOut[i] = lIn;
+            rightOut[i] = rIn;
         }
 
+        crossFader_.SetPos(patchCtrls_->resonatorVol);
+        crossFader_.Process(leftOut, wets_[LEFT_CHANNEL].subArray(0, size), leftOut);
+        crossFader_.Process(rightOut, wets_[RIGHT_CHANNEL].subArray(0, size), rightOut);
+
         compressor_->process(output, output);
     }
 };
\ No newline at end of file
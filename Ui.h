@@ -104,6 +104,7 @@ public:
         patchState_->randomHasSlew = false;
         patchState_->modAttenuverters = false;
         patchState_->cvAttenuverters = false;
+        patchState_->filterControlRate = kFilterControlRate;
 
         for (size_t i = 0; i < PARAM_KNOB_LAST + PARAM_FADER_LAST; i++) {
             patchState_->moving[i] = false;
@@ -570,7 +571,7 @@ public:
     void HandleLeds() {
         float level = patchState_->outputLevel.getMaxValue();
         if (level < 0.6f) {
-            leds_[LED_INPUT]->Set(Map(level, 0.f, 0.6f, 0.45f, 1.f));
+            leds_[LED_INPUT]->Set(Range(0.f, 0.6f, 0.45f, 1.f).Map(level));
             leds_[LED_INPUT_PEAK]->Off();
         }
         else {
@@ -578,7 +579,7 @@ public:
             leds_[LED_INPUT_PEAK]->On();
         }
 
-        float v = Map(patchState_->modValue, -0.5f, 0.5f, 0.49f, 0.5f + patchCtrls_->modLevel * 0.5f);
+        float v = Range(-0.5f, 0.5f, 0.49f, 0.5f + patchCtrls_->modLevel * 0.5f).Map(patchState_->modValue);
         if (v < 0.5f)
         {
             v = 0;
@@ -0,0 +1,181 @@
+#pragma once
+
+// Timestamped automation for the host tools. A file has one point per line:
+//
+//   <seconds> <target> <value>
+//
+// '#' starts a comment. Points of a target don't need to be in order. The
+// value of a target between two points is interpolated linearly, two points
+// at the same time make a step. Before its first and after its last point a
+// target holds the value of that point.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+struct AutomationPoint
+{
+    double time;
+    float value;
+};
+
+class AutomationTrack
+{
+private:
+    std::string name_;
+    std::vector<AutomationPoint> points_;
+
+public:
+    AutomationTrack(const char* name) : name_(name) {}
+
+    const char* GetName() const
+    {
+        return name_.c_str();
+    }
+
+    size_t GetSize() const
+    {
+        return points_.size();
+    }
+
+    const AutomationPoint& operator[](size_t index) const
+    {
+        return points_[index];
+    }
+
+    // Keeps the points sorted, after the ones at the same time.
+    void Add(double time, float value)
+    {
+        AutomationPoint point = { time, value };
+        std::vector<AutomationPoint>::iterator it = std::upper_bound(points_.begin(), points_.end(), point,
+            [](const AutomationPoint& a, const AutomationPoint& b) { return a.time < b.time; });
+        points_.insert(it, point);
+    }
+
+    /**
+     * @brief The value at a time, interpolated between the points around it.
+     */
+    float Interpolate(double time) const
+    {
+        if (points_.empty())
+        {
+            return 0.f;
+        }
+        size_t i = FindAfter(time);
+        if (i == 0)
+        {
+            return points_[0].value;
+        }
+        if (i == points_.size())
+        {
+            return points_[i - 1].value;
+        }
+        const AutomationPoint& a = points_[i - 1];
+        const AutomationPoint& b = points_[i];
+
+        return a.value + (b.value - a.value) * (time - a.time) / (b.time - a.time);
+    }
+
+    /**
+     * @brief The value of the last point at or before a time, for the
+     *        targets that don't interpolate (buttons, gates).
+     */
+    float Hold(double time) const
+    {
+        size_t i = FindAfter(time);
+
+        return i == 0 ? (points_.empty() ? 0.f : points_[0].value) : points_[i - 1].value;
+    }
+
+    /**
+     * @brief The index of the first point after a time.
+     */
+    size_t FindAfter(double time) const
+    {
+        size_t i = 0;
+        while (i < points_.size() && points_[i].time <= time)
+        {
+            i++;
+        }
+
+        return i;
+    }
+};
+
+class Automation
+{
+private:
+    std::vector<AutomationTrack> tracks_;
+
+public:
+    size_t GetSize() const
+    {
+        return tracks_.size();
+    }
+
+    const AutomationTrack& operator[](size_t index) const
+    {
+        return tracks_[index];
+    }
+
+    AutomationTrack& GetTrack(const char* name)
+    {
+        for (size_t i = 0; i < tracks_.size(); i++)
+        {
+            if (!strcmp(tracks_[i].GetName(), name))
+            {
+                return tracks_[i];
+            }
+        }
+        tracks_.push_back(AutomationTrack(name));
+
+        return tracks_.back();
+    }
+
+    /**
+     * @return false, with a message on stderr, if the file can't be read or
+     *         has a malformed line
+     */
+    bool Load(const char* path)
+    {
+        FILE* f = fopen(path, "r");
+        if (f == NULL)
+        {
+            fprintf(stderr, "%s: can't open\n", path);
+            return false;
+        }
+
+        char line[256];
+        int number = 0;
+        bool ok = true;
+        while (ok && fgets(line, sizeof(line), f))
+        {
+            number++;
+            char* comment = strchr(line, '#');
+            if (comment)
+            {
+                *comment = '\0';
+            }
+            double time;
+            char name[64];
+            float value;
+            char rest;
+            int fields = sscanf(line, "%lf %63s %f %c", &time, name, &value, &rest);
+            if (fields == 3 && time >= 0)
+            {
+                GetTrack(name).Add(time, value);
+            }
+            else if (fields != EOF)
+            {
+                fprintf(stderr, "%s:%d: expected <seconds> <target> <value>\n", path, number);
+                ok = false;
+            }
+        }
+        fclose(f);
+
+        return ok;
+    }
+};
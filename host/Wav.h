@@ -0,0 +1,189 @@
+#pragma once
+
+// Minimal WAV file reading and writing for the host tools. Reads 16, 24 and
+// 32 bit PCM and 32 bit float files, writes 32 bit float ones.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+struct Wav
+{
+    int sampleRate;
+    int channels;
+    std::vector<float> samples; // Interleaved
+
+    Wav() : sampleRate(48000), channels(2) {}
+
+    size_t GetFrames() const
+    {
+        return channels ? samples.size() / channels : 0;
+    }
+
+    float Get(size_t frame, int channel) const
+    {
+        return samples[frame * channels + (channel < channels ? channel : channels - 1)];
+    }
+};
+
+namespace wav
+{
+constexpr uint16_t kFormatPcm = 1;
+constexpr uint16_t kFormatFloat = 3;
+constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+inline uint32_t ReadU32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline uint16_t ReadU16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+inline void WriteU32(FILE* f, uint32_t v)
+{
+    uint8_t b[4] = { uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24) };
+    fwrite(b, 1, 4, f);
+}
+
+inline void WriteU16(FILE* f, uint16_t v)
+{
+    uint8_t b[2] = { uint8_t(v), uint8_t(v >> 8) };
+    fwrite(b, 1, 2, f);
+}
+} // namespace wav
+
+/**
+ * @return false, with a message on stderr, if the file can't be read or its
+ *         format isn't supported
+ */
+inline bool ReadWav(const char* path, Wav& out)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL)
+    {
+        fprintf(stderr, "%s: can't open\n", path);
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(f);
+
+    if (data.size() < 12 || memcmp(&data[0], "RIFF", 4) || memcmp(&data[8], "WAVE", 4))
+    {
+        fprintf(stderr, "%s: not a WAV file\n", path);
+        return false;
+    }
+
+    uint16_t format = 0;
+    uint16_t bits = 0;
+    const uint8_t* pcm = NULL;
+    size_t pcmSize = 0;
+    size_t pos = 12;
+    while (pos + 8 <= data.size())
+    {
+        const uint8_t* p = &data[pos];
+        size_t size = wav::ReadU32(p + 4);
+        size_t available = data.size() - pos - 8;
+        if (size > available)
+        {
+            size = available;
+        }
+        if (!memcmp(p, "fmt ", 4) && size >= 16)
+        {
+            format = wav::ReadU16(p + 8);
+            out.channels = wav::ReadU16(p + 10);
+            out.sampleRate = wav::ReadU32(p + 12);
+            bits = wav::ReadU16(p + 22);
+            if (format == wav::kFormatExtensible && size >= 26)
+            {
+                format = wav::ReadU16(p + 32);
+            }
+        }
+        else if (!memcmp(p, "data", 4))
+        {
+            pcm = p + 8;
+            pcmSize = size;
+        }
+        pos += 8 + size + (size & 1);
+    }
+
+    bool pcmOk = format == wav::kFormatPcm && (bits == 16 || bits == 24 || bits == 32);
+    bool floatOk = format == wav::kFormatFloat && bits == 32;
+    if (pcm == NULL || out.channels < 1 || !(pcmOk || floatOk))
+    {
+        fprintf(stderr, "%s: unsupported format %d, %d bits\n", path, format, bits);
+        return false;
+    }
+
+    size_t bytes = bits / 8;
+    size_t count = pcmSize / bytes;
+    count -= count % out.channels;
+    out.samples.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t* p = pcm + i * bytes;
+        if (floatOk)
+        {
+            uint32_t v = wav::ReadU32(p);
+            memcpy(&out.samples[i], &v, 4);
+        }
+        else if (bits == 16)
+        {
+            out.samples[i] = int16_t(wav::ReadU16(p)) / 32768.f;
+        }
+        else if (bits == 24)
+        {
+            int32_t v = (p[0] << 8) | (p[1] << 16) | ((uint32_t)p[2] << 24);
+            out.samples[i] = (v >> 8) / 8388608.f;
+        }
+        else
+        {
+            out.samples[i] = int32_t(wav::ReadU32(p)) / 2147483648.f;
+        }
+    }
+
+    return true;
+}
+
+inline bool WriteWav(const char* path, const Wav& in)
+{
+    FILE* f = fopen(path, "wb");
+    if (f == NULL)
+    {
+        fprintf(stderr, "%s: can't create\n", path);
+        return false;
+    }
+
+    uint32_t dataSize = in.samples.size() * 4;
+    fwrite("RIFF", 1, 4, f);
+    wav::WriteU32(f, 36 + dataSize);
+    fwrite("WAVEfmt ", 1, 8, f);
+    wav::WriteU32(f, 16);
+    wav::WriteU16(f, wav::kFormatFloat);
+    wav::WriteU16(f, in.channels);
+    wav::WriteU32(f, in.sampleRate);
+    wav::WriteU32(f, in.sampleRate * in.channels * 4);
+    wav::WriteU16(f, in.channels * 4);
+    wav::WriteU16(f, 32);
+    fwrite("data", 1, 4, f);
+    wav::WriteU32(f, dataSize);
+    for (size_t i = 0; i < in.samples.size(); i++)
+    {
+        uint32_t v;
+        memcpy(&v, &in.samples[i], 4);
+        wav::WriteU32(f, v);
+    }
+    bool ok = !ferror(f);
+    fclose(f);
+
+    return ok;
+}
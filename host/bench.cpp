@@ -0,0 +1,622 @@
+// Microbenchmarks of the DSP blocks, in ns per sample (per frame for the
+// stereo ones).
+//
+// Each benchmark runs a block over a fixed input (noise and a sine, from a
+// fixed seed) with its parameters swept once per block over the ranges the
+// patch uses, and is repeated to report the fastest and the median run. A
+// checksum of the outputs is printed too: it must not change between runs
+// and builds that don't touch the benchmarked code, and it keeps the
+// compiler from dropping the work.
+
+#include "Commons.h"
+#include "DelayLine.h"
+#include "Filter.h"
+#include "Resonator.h"
+#include "Ambience.h"
+#include "Compressor.h"
+#include "DjFilter.h"
+#include "ChaosNoise.h"
+#include "EnvFollower.h"
+#include "LorenzAttractor.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+constexpr float kBenchSampleRate = 48000.f;
+constexpr int kBenchBlockSize = 64;
+
+/**
+ * @brief Times the processing part of a benchmark, leaving out the setup.
+ */
+class BenchTimer
+{
+private:
+    std::chrono::steady_clock::time_point start_;
+    double ns_;
+
+public:
+    BenchTimer() : ns_(0) {}
+
+    void Start()
+    {
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    void Stop()
+    {
+        ns_ = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    double GetNs() const
+    {
+        return ns_;
+    }
+};
+
+struct BenchInput
+{
+    std::vector<float> left;
+    std::vector<float> right;
+
+    size_t GetSize() const
+    {
+        return left.size();
+    }
+
+    // Number of whole blocks.
+    size_t GetBlocks() const
+    {
+        return left.size() / kBenchBlockSize;
+    }
+};
+
+/**
+ * @brief Position of a block in a triangle sweep going from 0 to 1 and
+ *        back over the whole input.
+ */
+static float Sweep(size_t block, size_t blocks)
+{
+    float x = 2.f * block / blocks;
+
+    return x <= 1.f ? x : 2.f - x;
+}
+
+static float Lerp(float from, float to, float x)
+{
+    return from + (to - from) * x;
+}
+
+// Returns the checksum of the outputs.
+typedef double (*BenchFunction)(const BenchInput& in, BenchTimer& timer);
+
+static double BenchDelayLineInteger(const BenchInput& in, BenchTimer& timer)
+{
+    DelayLine<>* line = DelayLine<>::create(kEchoMaxLengthSamples);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        int delay = Lerp(kBenchBlockSize, kEchoMaxLengthSamples - 2, Sweep(b, blocks));
+        for (size_t i = b * kBenchBlockSize; i < (b + 1) * kBenchBlockSize; i++)
+        {
+            line->write(in.left[i]);
+            sum += line->readAt(delay);
+        }
+    }
+    timer.Stop();
+    DelayLine<>::destroy(line);
+
+    return sum;
+}
+
+static double BenchDelayLineFractional(const BenchInput& in, BenchTimer& timer)
+{
+    DelayLine<>* line = DelayLine<>::create(kEchoMaxLengthSamples);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    float delay = kBenchBlockSize;
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        // Glides to the next delay like a modulated tap.
+        float target = Lerp(kBenchBlockSize, kEchoMaxLengthSamples - 2, Sweep(b + 1, blocks));
+        float inc = (target - delay) / kBenchBlockSize;
+        for (size_t i = b * kBenchBlockSize; i < (b + 1) * kBenchBlockSize; i++)
+        {
+            line->write(in.left[i]);
+            delay += inc;
+            sum += line->read(delay);
+        }
+    }
+    timer.Stop();
+    DelayLine<>::destroy(line);
+
+    return sum;
+}
+
+static double BenchDelayLineCrossfaded(const BenchInput& in, BenchTimer& timer)
+{
+    DelayLine<>* line = DelayLine<>::create(kEchoMaxLengthSamples);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    float delay = kBenchBlockSize + 0.5f;
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        // Crossfades to a new tap time every block, like the echo taps.
+        float next = Lerp(kBenchBlockSize, kEchoMaxLengthSamples - 2, Sweep(b + 1, blocks)) + 0.5f;
+        float x = 0;
+        for (size_t i = b * kBenchBlockSize; i < (b + 1) * kBenchBlockSize; i++)
+        {
+            line->write(in.left[i]);
+            sum += line->read(delay, next, x);
+            x += 1.f / kBenchBlockSize;
+        }
+        delay = next;
+    }
+    timer.Stop();
+    DelayLine<>::destroy(line);
+
+    return sum;
+}
+
+static double BenchDelayLineReadBlock(const BenchInput& in, BenchTimer& timer)
+{
+    DelayLine<>* line = DelayLine<>::create(kEchoMaxLengthSamples);
+    FloatArray out = FloatArray::create(kBenchBlockSize);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    float delay = kBenchBlockSize + 0.5f;
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        float next = Lerp(kBenchBlockSize, kEchoMaxLengthSamples - 2, Sweep(b + 1, blocks)) + 0.5f;
+        line->readBlock(out, delay, next, 0.f, 1.f / kBenchBlockSize);
+        line->writeBlock(FloatArray((float*)&in.left[b * kBenchBlockSize], kBenchBlockSize));
+        for (int i = 0; i < kBenchBlockSize; i++)
+        {
+            sum += out[i];
+        }
+        delay = next;
+    }
+    timer.Stop();
+    FloatArray::destroy(out);
+    DelayLine<>::destroy(line);
+
+    return sum;
+}
+
+static double BenchPole(const BenchInput& in, BenchTimer& timer)
+{
+    // The three poles of the resonator on their comb bank.
+    PoleTable* table = PoleTable::create(kBenchSampleRate);
+    CombBank* bank = CombBank::create();
+    Pole* poles[3] = {
+        Pole::create(table, bank, RESO_LANE_POLE_0_LEFT, RESO_LANE_POLE_0_RIGHT),
+        Pole::create(table, bank, RESO_LANE_POLE_1_LEFT, -1),
+        Pole::create(table, bank, -1, RESO_LANE_POLE_2_RIGHT),
+    };
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        float x = Sweep(b, blocks);
+        bank->SetFeedback(Lerp(0.85f, 1.f, x));
+        for (int p = 0; p < 3; p++)
+        {
+            poles[p]->SetSemiOffset(Lerp(-24.f, 24.f, x) + p * 7);
+            poles[p]->SetDissonance(x * 0.5f);
+            poles[p]->SetReso(Lerp(0.5f, 0.6f, x));
+            poles[p]->SetFilter(Lerp(5000.f, 10000.f, x));
+        }
+        for (size_t i = b * kBenchBlockSize; i < (b + 1) * kBenchBlockSize; i++)
+        {
+            float ins[RESO_LANE_LAST] = { in.left[i], in.right[i], in.left[i], in.right[i] };
+            float outs[RESO_LANE_LAST];
+            bank->Process(ins, outs);
+            sum += outs[RESO_LANE_POLE_0_LEFT] + outs[RESO_LANE_POLE_0_RIGHT];
+            sum += outs[RESO_LANE_POLE_1_LEFT] + outs[RESO_LANE_POLE_2_RIGHT];
+        }
+    }
+    timer.Stop();
+    for (int p = 0; p < 3; p++)
+    {
+        Pole::destroy(poles[p]);
+    }
+    CombBank::destroy(bank);
+    PoleTable::destroy(table);
+
+    return sum;
+}
+
+static double BenchDiffuse(const BenchInput& in, BenchTimer& timer)
+{
+    Diffuse* diffuse = Diffuse::create(kBenchBlockSize, kBenchSampleRate);
+    FloatArray left = FloatArray::create(kBenchBlockSize);
+    FloatArray right = FloatArray::create(kBenchBlockSize);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        // Ambience::SetSize() and SetDecay() ranges.
+        float x = Sweep(b, blocks);
+        float size = Lerp(0.1f, 60.f, x);
+        diffuse->SetSZ(-(size - 30.f));
+        diffuse->SetDf(size * 0.004166667f + 0.5f);
+        diffuse->SetRT(kAmbienceDecayLut.Lookup(x));
+        diffuse->PrepareBlock(kBenchBlockSize, 0.f, 1.f / kBenchBlockSize);
+        for (int i = 0; i < kBenchBlockSize; i++)
+        {
+            left[i] = in.left[b * kBenchBlockSize + i] + diffuse->GetFbOut(RIGHT_CHANNEL, i);
+            right[i] = in.right[b * kBenchBlockSize + i] + diffuse->GetFbOut(LEFT_CHANNEL, i);
+        }
+        diffuse->Process(left, right);
+        diffuse->UpdateDelayTimes();
+        for (int i = 0; i < kBenchBlockSize; i++)
+        {
+            sum += left[i] + right[i];
+        }
+    }
+    timer.Stop();
+    FloatArray::destroy(left);
+    FloatArray::destroy(right);
+    Diffuse::destroy(diffuse);
+
+    return sum;
+}
+
+static double BenchReversedBuffer(const BenchInput& in, BenchTimer& timer)
+{
+    ReversedBuffer* reverser = ReversedBuffer::create(kAmbienceBufferSize);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        reverser->SetDelay(Lerp(kBenchBlockSize, kAmbienceBufferSize / 2, Sweep(b, blocks)));
+        for (size_t i = b * kBenchBlockSize; i < (b + 1) * kBenchBlockSize; i++)
+        {
+            sum += reverser->Process(in.left[i]);
+        }
+    }
+    timer.Stop();
+    ReversedBuffer::destroy(reverser);
+
+    return sum;
+}
+
+static double BenchAllpass(const BenchInput& in, BenchTimer& timer)
+{
+    // The variable pole of the comb filter, gliding between notes.
+    Allpass* allpass = Allpass::create(kBenchSampleRate, 1468);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        allpass->SetDelay(Lerp(4.f, 734.f, Sweep(b, blocks)));
+        allpass->SetC(Lerp(0.5f, 0.9f, Sweep(b, blocks)));
+        for (size_t i = b * kBenchBlockSize; i < (b + 1) * kBenchBlockSize; i++)
+        {
+            sum += allpass->Process(in.left[i]);
+        }
+    }
+    timer.Stop();
+    Allpass::destroy(allpass);
+
+    return sum;
+}
+
+static double BenchAllpassFixed(const BenchInput& in, BenchTimer& timer)
+{
+    Allpass* allpass = Allpass::create(kBenchSampleRate, 2);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        allpass->SetC(Lerp(0.5f, 0.9f, Sweep(b, blocks)));
+        for (size_t i = b * kBenchBlockSize; i < (b + 1) * kBenchBlockSize; i++)
+        {
+            sum += allpass->ProcessFixed(in.left[i]);
+        }
+    }
+    timer.Stop();
+    Allpass::destroy(allpass);
+
+    return sum;
+}
+
+static double BenchCombFilter(const BenchInput& in, BenchTimer& timer)
+{
+    CombFilter* comb = CombFilter::create(kBenchSampleRate);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        // The notes and resonances of Filter::SetNote() in comb mode.
+        float x = Sweep(b, blocks);
+        comb->SetNote(Lerp(14.f, 127.f, x));
+        comb->SetResonance(Lerp(0.4f, 0.85f, x));
+        for (size_t i = b * kBenchBlockSize; i < (b + 1) * kBenchBlockSize; i++)
+        {
+            sum += comb->Process(in.left[i]);
+        }
+    }
+    timer.Stop();
+    CombFilter::destroy(comb);
+
+    return sum;
+}
+
+static double BenchCompressor(const BenchInput& in, BenchTimer& timer)
+{
+    Compressor* compressor = Compressor::create(kBenchSampleRate);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        // Sweeps the input level across the threshold.
+        float gain = Lerp(0.1f, 4.f, Sweep(b, blocks));
+        for (size_t i = b * kBenchBlockSize; i < (b + 1) * kBenchBlockSize; i++)
+        {
+            sum += compressor->process(in.left[i] * gain);
+        }
+    }
+    timer.Stop();
+    Compressor::destroy(compressor);
+
+    return sum;
+}
+
+static double BenchCompressorStereo(const BenchInput& in, BenchTimer& timer)
+{
+    Compressor* compressor = Compressor::create(kBenchSampleRate);
+    AudioBuffer* input = AudioBuffer::create(2, kBenchBlockSize);
+    AudioBuffer* output = AudioBuffer::create(2, kBenchBlockSize);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        float gain = Lerp(0.1f, 4.f, Sweep(b, blocks));
+        FloatArray left = input->getSamples(LEFT_CHANNEL);
+        FloatArray right = input->getSamples(RIGHT_CHANNEL);
+        for (int i = 0; i < kBenchBlockSize; i++)
+        {
+            left[i] = in.left[b * kBenchBlockSize + i] * gain;
+            right[i] = in.right[b * kBenchBlockSize + i] * gain;
+        }
+        compressor->process(*input, *output);
+        for (int i = 0; i < kBenchBlockSize; i++)
+        {
+            sum += output->getSamples(LEFT_CHANNEL)[i] + output->getSamples(RIGHT_CHANNEL)[i];
+        }
+    }
+    timer.Stop();
+    AudioBuffer::destroy(input);
+    AudioBuffer::destroy(output);
+    Compressor::destroy(compressor);
+
+    return sum;
+}
+
+static double BenchDjFilter(const BenchInput& in, BenchTimer& timer)
+{
+    DjFilter* filter = DjFilter::create(kBenchSampleRate);
+    AudioBuffer* input = AudioBuffer::create(2, kBenchBlockSize);
+    AudioBuffer* output = AudioBuffer::create(2, kBenchBlockSize);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        // Low pass, off and high pass in turn.
+        filter->SetFilter(Sweep(b, blocks));
+        FloatArray left = input->getSamples(LEFT_CHANNEL);
+        FloatArray right = input->getSamples(RIGHT_CHANNEL);
+        for (int i = 0; i < kBenchBlockSize; i++)
+        {
+            left[i] = in.left[b * kBenchBlockSize + i];
+            right[i] = in.right[b * kBenchBlockSize + i];
+        }
+        filter->Process(*input, *output);
+        for (int i = 0; i < kBenchBlockSize; i++)
+        {
+            sum += output->getSamples(LEFT_CHANNEL)[i] + output->getSamples(RIGHT_CHANNEL)[i];
+        }
+    }
+    timer.Stop();
+    AudioBuffer::destroy(input);
+    AudioBuffer::destroy(output);
+    DjFilter::destroy(filter);
+
+    return sum;
+}
+
+static double BenchChaosNoise(const BenchInput& in, BenchTimer& timer)
+{
+    ChaosNoise noise;
+    noise.Init(kBenchSampleRate);
+    noise.SetChaos(kFilterChaosNoise);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        // The filter cutoffs.
+        noise.SetFreq(Lerp(10.f, 20000.f, Sweep(b, blocks)));
+        for (int i = 0; i < kBenchBlockSize; i++)
+        {
+            sum += noise.Process();
+        }
+    }
+    timer.Stop();
+
+    return sum;
+}
+
+static double BenchEnvFollower(const BenchInput& in, BenchTimer& timer)
+{
+    EnvFollower* ef = EnvFollower::create();
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        float gain = Lerp(0.1f, 2.f, Sweep(b, blocks));
+        for (size_t i = b * kBenchBlockSize; i < (b + 1) * kBenchBlockSize; i++)
+        {
+            sum += ef->process(in.left[i] * gain);
+        }
+    }
+    timer.Stop();
+    EnvFollower::destroy(ef);
+
+    return sum;
+}
+
+static double BenchLorenzAttractor(const BenchInput& in, BenchTimer& timer)
+{
+    LorenzAttractor* lorenz = LorenzAttractor::create(kBenchSampleRate);
+    double sum = 0;
+    size_t blocks = in.GetBlocks();
+    timer.Start();
+    for (size_t b = 0; b < blocks; b++)
+    {
+        float x = Sweep(b, blocks);
+        lorenz->setFrequency(Lerp(0.01f, 80.f, x));
+        lorenz->setChaos(Lerp(0.5f, 3.f, x));
+        for (int i = 0; i < kBenchBlockSize; i++)
+        {
+            sum += lorenz->generate();
+        }
+    }
+    timer.Stop();
+    LorenzAttractor::destroy(lorenz);
+
+    return sum;
+}
+
+struct Bench
+{
+    const char* name;
+    BenchFunction function;
+};
+
+static const Bench kBenches[] = {
+    { "delayline.read.integer", BenchDelayLineInteger },
+    { "delayline.read.fractional", BenchDelayLineFractional },
+    { "delayline.read.crossfaded", BenchDelayLineCrossfaded },
+    { "delayline.readblock.crossfaded", BenchDelayLineReadBlock },
+    { "pole", BenchPole },
+    { "diffuse", BenchDiffuse },
+    { "reversedbuffer", BenchReversedBuffer },
+    { "allpass.process", BenchAllpass },
+    { "allpass.processfixed", BenchAllpassFixed },
+    { "combfilter", BenchCombFilter },
+    { "compressor.mono", BenchCompressor },
+    { "compressor.stereo", BenchCompressorStereo },
+    { "djfilter", BenchDjFilter },
+    { "chaosnoise", BenchChaosNoise },
+    { "envfollower", BenchEnvFollower },
+    { "lorenzattractor", BenchLorenzAttractor },
+};
+
+static void MakeInput(BenchInput& in, size_t size, unsigned int seed)
+{
+    in.left.resize(size);
+    in.right.resize(size);
+    srand(seed);
+    for (size_t i = 0; i < size; i++)
+    {
+        float sine = 0.5f * sinf(2 * M_PI * 220.f * i / kBenchSampleRate);
+        in.left[i] = sine + 0.25f * (2.f * rand() / RAND_MAX - 1.f);
+        in.right[i] = sine + 0.25f * (2.f * rand() / RAND_MAX - 1.f);
+    }
+}
+
+static void Usage()
+{
+    fprintf(stderr,
+        "usage: iroi-bench [-n samples] [-r runs] [-s seed] [name...]\n"
+        "  -n  samples per run, 96000 (2 seconds) by default\n"
+        "  -r  runs of each benchmark, 11 by default\n"
+        "  -s  seed of the input noise, 1 by default\n"
+        "  name  only run the benchmarks starting with one of the names\n");
+}
+
+int main(int argc, char** argv)
+{
+    size_t samples = 96000;
+    int runs = 11;
+    unsigned int seed = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:s:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            samples = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            runs = atoi(optarg);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            Usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (samples < 2 * kBenchBlockSize || runs < 1)
+    {
+        Usage();
+        return 1;
+    }
+
+    BenchInput in;
+    MakeInput(in, samples - samples % kBenchBlockSize, seed);
+
+    printf("%-32s %10s %10s  %s\n", "benchmark", "ns/sample", "median", "checksum");
+    for (size_t b = 0; b < sizeof(kBenches) / sizeof(kBenches[0]); b++)
+    {
+        const Bench& bench = kBenches[b];
+        bool selected = optind == argc;
+        for (int i = optind; i < argc; i++)
+        {
+            selected |= !strncmp(bench.name, argv[i], strlen(argv[i]));
+        }
+        if (!selected)
+        {
+            continue;
+        }
+
+        std::vector<double> times(runs);
+        double checksum = 0;
+        for (int r = 0; r < runs; r++)
+        {
+            BenchTimer timer;
+            double sum = bench.function(in, timer);
+            if (r > 0 && sum != checksum)
+            {
+                fprintf(stderr, "%s: checksum changed between runs, %.9g then %.9g\n", bench.name, checksum, sum);
+                return 1;
+            }
+            checksum = sum;
+            times[r] = timer.GetNs() / in.GetSize();
+        }
+        std::sort(times.begin(), times.end());
+        printf("%-32s %10.2f %10.2f  %.9g\n", bench.name, times[0], times[runs / 2], checksum);
+    }
+
+    return 0;
+}
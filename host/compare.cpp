@@ -0,0 +1,177 @@
+// Compares a render against a reference and fails if they differ by more
+// than the tolerances:
+// - max abs error: largest difference between two samples
+// - null residual: energy of the difference relative to the reference, in
+//   dB (the level left when nulling one against the other)
+// - spectral distance: log spectral distance in dB, the RMS over the bins
+//   of the difference of the power spectra, averaged over Hann windowed
+//   frames of kCompareFrameSize samples. Bins more than kCompareRange
+//   below the loudest one of the reference frame count as that level, so
+//   that noise far below the signal doesn't dominate.
+
+#include "FastFourierTransform.h"
+#include "Wav.h"
+#include <math.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+constexpr int kCompareFrameSize = 2048;
+constexpr double kComparePowerFloor = 1e-12; // -120dB, below this frames are silent
+constexpr double kCompareRange = 1e-6; // 60dB
+
+struct CompareResult
+{
+    double maxAbsError;
+    double nullResidual;
+    double spectralDistance;
+};
+
+static double PowerDb(double power, double floor)
+{
+    return 10 * log10(power > floor ? power : floor);
+}
+
+static double SpectralDistance(const Wav& reference, const Wav& test, int channel)
+{
+    FastFourierTransform fft(kCompareFrameSize);
+    std::vector<float> window(kCompareFrameSize), in(kCompareFrameSize), spectra[2];
+    std::vector<double> powers[2];
+    for (int w = 0; w < 2; w++)
+    {
+        spectra[w].resize(kCompareFrameSize);
+        powers[w].resize(kCompareFrameSize / 2 + 1);
+    }
+    for (int i = 0; i < kCompareFrameSize; i++)
+    {
+        window[i] = 0.5f - 0.5f * cosf(2 * M_PI * i / kCompareFrameSize);
+    }
+
+    double sum = 0;
+    int frames = 0;
+    for (size_t start = 0; start + kCompareFrameSize <= reference.GetFrames(); start += kCompareFrameSize / 2)
+    {
+        const Wav* wavs[2] = { &reference, &test };
+        for (int w = 0; w < 2; w++)
+        {
+            for (int i = 0; i < kCompareFrameSize; i++)
+            {
+                in[i] = wavs[w]->Get(start + i, channel) * window[i];
+            }
+            fft.fft(FloatArray(in.data(), kCompareFrameSize), ComplexFloatArray((ComplexFloat*)spectra[w].data(), kCompareFrameSize / 2));
+        }
+
+        // Bin powers from the packed spectra: DC and Nyquist first, then
+        // re/im pairs.
+        for (int w = 0; w < 2; w++)
+        {
+            float* x = spectra[w].data();
+            powers[w][0] = x[0] * x[0];
+            powers[w][kCompareFrameSize / 2] = x[1] * x[1];
+            for (int k = 1; k < kCompareFrameSize / 2; k++)
+            {
+                powers[w][k] = x[2 * k] * x[2 * k] + x[2 * k + 1] * x[2 * k + 1];
+            }
+        }
+
+        double peak = 0;
+        for (int k = 0; k <= kCompareFrameSize / 2; k++)
+        {
+            peak = powers[0][k] > peak ? powers[0][k] : peak;
+        }
+        double floor = peak * kCompareRange > kComparePowerFloor ? peak * kCompareRange : kComparePowerFloor;
+
+        double d = 0;
+        for (int k = 0; k <= kCompareFrameSize / 2; k++)
+        {
+            double diff = PowerDb(powers[0][k], floor) - PowerDb(powers[1][k], floor);
+            d += diff * diff;
+        }
+        sum += sqrt(d / (kCompareFrameSize / 2 + 1));
+        frames++;
+    }
+
+    return frames ? sum / frames : 0;
+}
+
+static CompareResult Compare(const Wav& reference, const Wav& test)
+{
+    CompareResult result = { 0, 0, 0 };
+    double error = 0;
+    double energy = 0;
+    for (size_t i = 0; i < reference.samples.size(); i++)
+    {
+        double d = fabs(double(test.samples[i]) - reference.samples[i]);
+        result.maxAbsError = d > result.maxAbsError ? d : result.maxAbsError;
+        error += d * d;
+        energy += double(reference.samples[i]) * reference.samples[i];
+    }
+    result.nullResidual = error == 0 ? -INFINITY : 10 * log10(error / (energy > 0 ? energy : kComparePowerFloor));
+
+    for (int c = 0; c < reference.channels; c++)
+    {
+        double d = SpectralDistance(reference, test, c);
+        result.spectralDistance = d > result.spectralDistance ? d : result.spectralDistance;
+    }
+
+    return result;
+}
+
+static void Usage()
+{
+    fprintf(stderr,
+        "usage: iroi-compare [-e max-abs-error] [-n null-residual-db] [-s spectral-distance-db] reference.wav test.wav\n"
+        "  -e  largest sample difference, 1e-3 by default\n"
+        "  -n  highest difference energy relative to the reference, -60dB by default\n"
+        "  -s  highest log spectral distance (worst channel), 0.5dB by default\n");
+}
+
+int main(int argc, char** argv)
+{
+    double maxAbsError = 1e-3;
+    double nullResidual = -60;
+    double spectralDistance = 0.5;
+    int opt;
+    while ((opt = getopt(argc, argv, "e:n:s:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'e':
+            maxAbsError = atof(optarg);
+            break;
+        case 'n':
+            nullResidual = atof(optarg);
+            break;
+        case 's':
+            spectralDistance = atof(optarg);
+            break;
+        default:
+            Usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (argc - optind != 2)
+    {
+        Usage();
+        return 1;
+    }
+
+    Wav reference, test;
+    if (!ReadWav(argv[optind], reference) || !ReadWav(argv[optind + 1], test))
+    {
+        return 1;
+    }
+    if (reference.channels != test.channels || reference.samples.size() != test.samples.size())
+    {
+        fprintf(stderr, "%s: %d channels, %zu frames, expected %d channels, %zu frames\n", argv[optind + 1],
+            test.channels, test.GetFrames(), reference.channels, reference.GetFrames());
+        return 1;
+    }
+
+    CompareResult result = Compare(reference, test);
+    bool ok = result.maxAbsError <= maxAbsError && result.nullResidual <= nullResidual && result.spectralDistance <= spectralDistance;
+    printf("%s: max abs error %.3g (%.3g), null residual %.1fdB (%.1fdB), spectral distance %.3fdB (%.3fdB) %s\n",
+        argv[optind + 1], result.maxAbsError, maxAbsError, result.nullResidual, nullResidual,
+        result.spectralDistance, spectralDistance, ok ? "ok" : "FAILED");
+
+    return ok ? 0 : 1;
+}
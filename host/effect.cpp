@@ -0,0 +1,306 @@
+// Offline renderer of a single effect of the patch (filter, resonator, echo
+// or ambience), without the UI: the effect is driven through PatchCtrls,
+// PatchCvs and PatchState directly, with the values of an automation file
+// (see Automation.h).
+//
+// Targets are the names of the fields of PatchCtrls (filterCutoff,
+// echoDensity...) and of PatchCvs with a "cv." prefix (cv.echoDensity...),
+// in the units the effects use (filterCutoff is a note, the others are
+// mostly 0 to 1). modValue is the modulation output, syncIn the sync input.
+// All of them are read at the start of each block.
+
+#include "Commons.h"
+#include "Clock.h"
+#include "Ambience.h"
+#include "Filter.h"
+#include "Resonator.h"
+#include "Echo.h"
+#include "Wav.h"
+#include "Automation.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <unistd.h>
+
+enum EffectTargetType
+{
+    EFFECT_TARGET_CTRL,
+    EFFECT_TARGET_CV,
+    EFFECT_TARGET_MOD_VALUE,
+    EFFECT_TARGET_SYNC_IN,
+};
+
+struct EffectTarget
+{
+    const char* name;
+    EffectTargetType type;
+    size_t offset;
+};
+
+#define EFFECT_CTRL(field) { #field, EFFECT_TARGET_CTRL, offsetof(PatchCtrls, field) }
+#define EFFECT_CV(field) { "cv." #field, EFFECT_TARGET_CV, offsetof(PatchCvs, field) }
+
+static const EffectTarget kEffectTargets[] = {
+    EFFECT_CTRL(filterVol),
+    EFFECT_CTRL(filterMode),
+    EFFECT_CTRL(filterNoiseLevel),
+    EFFECT_CTRL(filterCutoff),
+    EFFECT_CTRL(filterCutoffModAmount),
+    EFFECT_CTRL(filterCutoffCvAmount),
+    EFFECT_CTRL(filterResonance),
+    EFFECT_CTRL(filterResonanceModAmount),
+    EFFECT_CTRL(filterResonanceCvAmount),
+    EFFECT_CTRL(resonatorVol),
+    EFFECT_CTRL(resonatorTune),
+    EFFECT_CTRL(resonatorTuneModAmount),
+    EFFECT_CTRL(resonatorTuneCvAmount),
+    EFFECT_CTRL(resonatorFeedback),
+    EFFECT_CTRL(resonatorFeedbackModAmount),
+    EFFECT_CTRL(resonatorFeedbackCvAmount),
+    EFFECT_CTRL(resonatorDissonance),
+    EFFECT_CTRL(echoVol),
+    EFFECT_CTRL(echoRepeats),
+    EFFECT_CTRL(echoRepeatsModAmount),
+    EFFECT_CTRL(echoRepeatsCvAmount),
+    EFFECT_CTRL(echoDensity),
+    EFFECT_CTRL(echoDensityModAmount),
+    EFFECT_CTRL(echoDensityCvAmount),
+    EFFECT_CTRL(echoFilter),
+    EFFECT_CTRL(ambienceVol),
+    EFFECT_CTRL(ambienceDecay),
+    EFFECT_CTRL(ambienceDecayModAmount),
+    EFFECT_CTRL(ambienceDecayCvAmount),
+    EFFECT_CTRL(ambienceSpacetime),
+    EFFECT_CTRL(ambienceSpacetimeModAmount),
+    EFFECT_CTRL(ambienceSpacetimeCvAmount),
+    EFFECT_CTRL(ambienceAutoPan),
+    EFFECT_CV(filterCutoff),
+    EFFECT_CV(filterResonance),
+    EFFECT_CV(resonatorTune),
+    EFFECT_CV(resonatorFeedback),
+    EFFECT_CV(echoRepeats),
+    EFFECT_CV(echoDensity),
+    EFFECT_CV(ambienceDecay),
+    EFFECT_CV(ambienceSpacetime),
+    { "modValue", EFFECT_TARGET_MOD_VALUE, 0 },
+    { "syncIn", EFFECT_TARGET_SYNC_IN, 0 },
+};
+
+static const EffectTarget* FindTarget(const char* name)
+{
+    for (size_t i = 0; i < sizeof(kEffectTargets) / sizeof(kEffectTargets[0]); i++)
+    {
+        if (!strcmp(kEffectTargets[i].name, name))
+        {
+            return &kEffectTargets[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Common interface of the effects, that only share the signature of
+ *        their process().
+ */
+class EffectRunner
+{
+public:
+    virtual ~EffectRunner() {}
+    virtual void process(AudioBuffer &buffer) = 0;
+};
+
+template <typename T>
+class EffectRunnerTemplate : public EffectRunner
+{
+private:
+    T* effect_;
+
+public:
+    EffectRunnerTemplate(PatchCtrls* patchCtrls, PatchCvs* patchCvs, PatchState* patchState)
+    {
+        effect_ = T::create(patchCtrls, patchCvs, patchState);
+    }
+    ~EffectRunnerTemplate()
+    {
+        T::destroy(effect_);
+    }
+
+    void process(AudioBuffer &buffer) override
+    {
+        effect_->process(buffer, buffer);
+    }
+};
+
+static EffectRunner* CreateEffect(const char* name, PatchCtrls* patchCtrls, PatchCvs* patchCvs, PatchState* patchState)
+{
+    if (!strcmp(name, "filter"))
+    {
+        return new EffectRunnerTemplate<Filter>(patchCtrls, patchCvs, patchState);
+    }
+    if (!strcmp(name, "resonator"))
+    {
+        return new EffectRunnerTemplate<Resonator>(patchCtrls, patchCvs, patchState);
+    }
+    if (!strcmp(name, "echo"))
+    {
+        return new EffectRunnerTemplate<Echo>(patchCtrls, patchCvs, patchState);
+    }
+    if (!strcmp(name, "ambience"))
+    {
+        return new EffectRunnerTemplate<Ambience>(patchCtrls, patchCvs, patchState);
+    }
+
+    return NULL;
+}
+
+static void Usage()
+{
+    fprintf(stderr,
+        "usage: iroi-effect [-a automation] [-b blocksize] [-s seed] filter|resonator|echo|ambience in.wav out.wav\n"
+        "  -a  timestamped controls, CVs, modValue and syncIn, see effect.cpp\n"
+        "  -b  block size, 64 by default\n"
+        "  -s  seed of the random generator, 1 by default\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* automationPath = NULL;
+    int blockSize = 64;
+    unsigned int seed = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "a:b:s:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'a':
+            automationPath = optarg;
+            break;
+        case 'b':
+            blockSize = atoi(optarg);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            Usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (argc - optind != 3 || blockSize < 1)
+    {
+        Usage();
+        return 1;
+    }
+    const char* effectName = argv[optind];
+
+    Wav in;
+    if (!ReadWav(argv[optind + 1], in))
+    {
+        return 1;
+    }
+
+    Automation automation;
+    if (automationPath && !automation.Load(automationPath))
+    {
+        return 1;
+    }
+    std::vector<const EffectTarget*> targets(automation.GetSize());
+    for (size_t i = 0; i < automation.GetSize(); i++)
+    {
+        targets[i] = FindTarget(automation[i].GetName());
+        if (targets[i] == NULL)
+        {
+            fprintf(stderr, "%s: unknown target %s\n", automationPath, automation[i].GetName());
+            return 1;
+        }
+    }
+
+    // The state the UI would set up, with the internal clock.
+    PatchCtrls patchCtrls = {};
+    PatchCvs patchCvs = {};
+    PatchState patchState = {};
+    patchState.sampleRate = in.sampleRate;
+    patchState.blockSize = blockSize;
+    patchState.blockRate = float(in.sampleRate) / blockSize;
+    patchState.inputLevel = FloatArray::create(blockSize);
+    patchState.outputLevel = FloatArray::create(blockSize);
+    patchState.efModLevel = FloatArray::create(blockSize);
+    patchState.outLevel = 1.f;
+    patchState.randomSlew = kRandomSlewSamples;
+    patchState.clockSource = CLOCK_SOURCE_INTERNAL;
+    patchState.filterControlRate = kFilterControlRate;
+    srand(seed);
+
+    auto apply = [&](double time)
+    {
+        for (size_t i = 0; i < automation.GetSize(); i++)
+        {
+            const EffectTarget* target = targets[i];
+            float value = target->type == EFFECT_TARGET_SYNC_IN ? automation[i].Hold(time) : automation[i].Interpolate(time);
+            switch (target->type)
+            {
+            case EFFECT_TARGET_CTRL:
+                *(float*)((char*)&patchCtrls + target->offset) = value;
+                break;
+            case EFFECT_TARGET_CV:
+                *(float*)((char*)&patchCvs + target->offset) = value;
+                break;
+            case EFFECT_TARGET_MOD_VALUE:
+                patchState.modValue = value;
+                break;
+            case EFFECT_TARGET_SYNC_IN:
+                patchState.syncIn = value != 0;
+                break;
+            }
+        }
+    };
+
+    // The effects read some of the controls when created.
+    apply(0);
+    Clock* clock = Clock::create(&patchCtrls, &patchState);
+    EffectRunner* effect = CreateEffect(effectName, &patchCtrls, &patchCvs, &patchState);
+    if (effect == NULL)
+    {
+        Usage();
+        return 1;
+    }
+    AudioBuffer* buffer = AudioBuffer::create(2, blockSize);
+
+    Wav out;
+    out.sampleRate = in.sampleRate;
+    out.channels = 2;
+    size_t frames = in.GetFrames();
+    out.samples.resize(frames * 2);
+
+    for (size_t start = 0; start < frames; start += blockSize)
+    {
+        apply(double(start) / in.sampleRate);
+
+        FloatArray left = buffer->getSamples(LEFT_CHANNEL);
+        FloatArray right = buffer->getSamples(RIGHT_CHANNEL);
+        for (int i = 0; i < blockSize; i++)
+        {
+            size_t frame = start + i;
+            left[i] = frame < frames ? in.Get(frame, 0) : 0.f;
+            right[i] = frame < frames ? in.Get(frame, 1) : 0.f;
+        }
+
+        clock->Process();
+        effect->process(*buffer);
+
+        for (int i = 0; i < blockSize && start + i < frames; i++)
+        {
+            out.samples[2 * (start + i)] = left[i];
+            out.samples[2 * (start + i) + 1] = right[i];
+        }
+    }
+
+    delete effect;
+    Clock::destroy(clock);
+    AudioBuffer::destroy(buffer);
+    FloatArray::destroy(patchState.inputLevel);
+    FloatArray::destroy(patchState.outputLevel);
+    FloatArray::destroy(patchState.efModLevel);
+
+    return WriteWav(argv[optind + 2], out) ? 0 : 1;
+}
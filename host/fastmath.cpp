@@ -0,0 +1,230 @@
+// Checks the bounds documented in FastMath.h against libm, in double
+// precision, over the whole documented ranges, and times the approximations
+// against the libm float functions they replace.
+//
+// Fails if one of the bounds doesn't hold. The timings are of the host, not
+// the Cortex-M7: only the ratios tell something.
+
+#include "FastMath.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+constexpr int kFastMathPoints = 1 << 20;
+
+struct FastMathResult
+{
+    double worst;
+    double worstX;
+    double worstY;
+};
+
+/**
+ * @brief The points of a sweep, evenly spaced from min to max, or
+ *        logarithmically for the log sweeps.
+ */
+static double SweepPoint(double min, double max, int i, int points, bool log)
+{
+    double x = double(i) / (points - 1);
+
+    return log ? min * pow(max / min, x) : min + (max - min) * x;
+}
+
+// Error of a function of one variable, relative or absolute.
+template <typename F, typename R>
+static FastMathResult Sweep1(F fast, R reference, double min, double max, bool log, bool relative)
+{
+    FastMathResult result = { 0, 0, 0 };
+    for (int i = 0; i < kFastMathPoints; i++)
+    {
+        float x = SweepPoint(min, max, i, kFastMathPoints, log);
+        double expected = reference(double(x));
+        double error = fabs(double(fast(x)) - expected);
+        if (relative)
+        {
+            error /= fabs(expected);
+        }
+        if (error > result.worst)
+        {
+            result.worst = error;
+            result.worstX = x;
+        }
+    }
+
+    return result;
+}
+
+static bool Report(const char* name, const char* range, const FastMathResult& result, double bound, bool twoArgs = false)
+{
+    bool ok = result.worst < bound;
+    if (twoArgs)
+    {
+        printf("%-14s %-28s %10.3g < %-8.3g at %g, %g %s\n", name, range, result.worst, bound, result.worstX, result.worstY, ok ? "ok" : "FAILED");
+    }
+    else
+    {
+        printf("%-14s %-28s %10.3g < %-8.3g at %g %s\n", name, range, result.worst, bound, result.worstX, ok ? "ok" : "FAILED");
+    }
+
+    return ok;
+}
+
+static bool CheckBounds()
+{
+    bool ok = true;
+    printf("%-14s %-28s %10s   %-8s\n", "function", "range", "error", "bound");
+
+    FastMathResult r = Sweep1([](float x) { return FastExp2(x); }, [](double x) { return exp2(x); }, -126, 127, false, true);
+    ok &= Report("FastExp2", "x in [-126, 127], relative", r, 2e-7);
+
+    r = Sweep1([](float x) { return FastExp2Table(x); }, [](double x) { return exp2(x); }, -126, 127, false, true);
+    ok &= Report("FastExp2Table", "x in [-126, 127], relative", r, 2e-6);
+
+    r = Sweep1([](float x) { return FastLog2(x); }, [](double x) { return log2(x); }, 1. / 16, 16, true, false);
+    ok &= Report("FastLog2", "x in [1/16, 16], absolute", r, 5e-7);
+
+    // Beyond [1/16, 16] the error grows with the exponent part, so it's
+    // relative there.
+    r = Sweep1([](float x) { return FastLog2(x); }, [](double x) { return log2(x); }, 1e-30, 1. / 16, true, true);
+    ok &= Report("FastLog2", "x in [1e-30, 1/16], relative", r, 2e-7);
+    r = Sweep1([](float x) { return FastLog2(x); }, [](double x) { return log2(x); }, 16, 1e30, true, true);
+    ok &= Report("FastLog2", "x in [16, 1e30], relative", r, 2e-7);
+
+    r = Sweep1([](float x) { return FastDb2A(x); }, [](double x) { return pow(10., x / 20.); }, -160, 160, false, true);
+    ok &= Report("FastDb2A", "dB in [-160, 160], relative", r, 1e-6);
+
+    r = Sweep1([](float x) { return FastM2F(x); }, [](double x) { return 440. * exp2((x - 69.) / 12.); }, -40, 160, false, true);
+    ok &= Report("FastM2F", "note in [-40, 160], relative", r, 1e-6);
+
+    // The bound of FastPow grows with |y| and |y * log2(x)|, check the ratio
+    // of the relative error to it. Results out of the range of FastExp2 are
+    // left out.
+    r = { 0, 0, 0 };
+    constexpr int kSteps = 2048;
+    for (int i = 0; i < kSteps; i++)
+    {
+        float x = SweepPoint(1. / (1 << 20), 1 << 20, i, kSteps, true);
+        for (int j = 0; j < kSteps; j++)
+        {
+            float y = SweepPoint(-8, 8, j, kSteps, false);
+            double l = fabs(y * log2(double(x)));
+            if (l > 120)
+            {
+                continue;
+            }
+            double expected = pow(double(x), double(y));
+            double error = fabs(FastPow(x, y) - expected) / expected / (1 + fabs(y) + l);
+            if (error > r.worst)
+            {
+                r.worst = error;
+                r.worstX = x;
+                r.worstY = y;
+            }
+        }
+    }
+    ok &= Report("FastPow", "x in [2^-20, 2^20], y in", r, 2e-7, true);
+    printf("%-14s %-28s %10s   (relative / (1 + |y| + |y log2(x)|))\n", "", "[-8, 8]", "");
+
+    return ok;
+}
+
+/**
+ * @brief ns per call of a function over an array of inputs, the best of a
+ *        few runs.
+ */
+template <typename F>
+static double Time(F function, const std::vector<float>& in, std::vector<float>& out)
+{
+    double best = 0;
+    for (int run = 0; run < 11; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < in.size(); i++)
+        {
+            out[i] = function(in[i]);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / in.size();
+        best = run == 0 || ns < best ? ns : best;
+    }
+
+    return best;
+}
+
+static void CompareTimes()
+{
+    constexpr size_t kTimedPoints = 1 << 16;
+    std::vector<float> exps(kTimedPoints), logs(kTimedPoints), dbs(kTimedPoints), notes(kTimedPoints), out(kTimedPoints);
+    srand(1);
+    for (size_t i = 0; i < kTimedPoints; i++)
+    {
+        float x = float(rand()) / RAND_MAX;
+        exps[i] = -20 + 40 * x;
+        logs[i] = 1e-3f + 100 * x;
+        dbs[i] = -160 + 320 * x;
+        notes[i] = -40 + 200 * x;
+    }
+
+    double sink = 0;
+    auto row = [&](const char* name, double fast, const char* libmName, double libm)
+    {
+        for (size_t i = 0; i < kTimedPoints; i++)
+        {
+            sink += out[i];
+        }
+        printf("%-14s %8.2f   %-22s %8.2f   x%.1f\n", name, fast, libmName, libm, libm / fast);
+    };
+
+    printf("\n%-14s %8s   %-22s %8s\n", "ns/call", "", "libm", "");
+    double fast = Time([](float x) { return FastExp2(x); }, exps, out);
+    row("FastExp2", fast, "exp2f", Time([](float x) { return exp2f(x); }, exps, out));
+    fast = Time([](float x) { return FastExp2Table(x); }, exps, out);
+    row("FastExp2Table", fast, "exp2f", Time([](float x) { return exp2f(x); }, exps, out));
+    fast = Time([](float x) { return FastLog2(x); }, logs, out);
+    row("FastLog2", fast, "log2f", Time([](float x) { return log2f(x); }, logs, out));
+    fast = Time([](float x) { return FastPow(x, 0.37f); }, logs, out);
+    row("FastPow", fast, "powf", Time([](float x) { return powf(x, 0.37f); }, logs, out));
+    fast = Time([](float x) { return FastDb2A(x); }, dbs, out);
+    row("FastDb2A", fast, "powf(10, db / 20)", Time([](float x) { return powf(10.f, x * 0.05f); }, dbs, out));
+    fast = Time([](float x) { return FastM2F(x); }, notes, out);
+    row("FastM2F", fast, "440 * exp2f(...)", Time([](float x) { return 440.f * exp2f((x - 69.f) * (1.f / 12.f)); }, notes, out));
+
+    // Keeps the loops.
+    printf("checksum %g\n", sink);
+}
+
+static void Usage()
+{
+    fprintf(stderr,
+        "usage: iroi-fastmath [-t]\n"
+        "  -t  time the functions against libm too\n");
+}
+
+int main(int argc, char** argv)
+{
+    bool timing = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "th")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            timing = true;
+            break;
+        default:
+            Usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    bool ok = CheckBounds();
+    if (timing)
+    {
+        CompareTimes();
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+// Host stand-in of the OWL AudioBuffer, owning its channels.
+
+#include "FloatArray.h"
+
+#define LEFT_CHANNEL 0
+#define RIGHT_CHANNEL 1
+
+class AudioBuffer
+{
+private:
+    FloatArray* channels_;
+    int nofChannels_;
+    size_t size_;
+
+public:
+    AudioBuffer(int channels, size_t size) : nofChannels_(channels), size_(size)
+    {
+        channels_ = new FloatArray[channels];
+        for (int c = 0; c < channels; c++)
+        {
+            channels_[c] = FloatArray::create(size);
+        }
+    }
+    ~AudioBuffer()
+    {
+        for (int c = 0; c < nofChannels_; c++)
+        {
+            FloatArray::destroy(channels_[c]);
+        }
+        delete[] channels_;
+    }
+
+    static AudioBuffer* create(int channels, size_t size)
+    {
+        return new AudioBuffer(channels, size);
+    }
+
+    static void destroy(AudioBuffer* obj)
+    {
+        delete obj;
+    }
+
+    FloatArray getSamples(int channel)
+    {
+        return channels_[channel];
+    }
+
+    int getChannels() const
+    {
+        return nofChannels_;
+    }
+
+    size_t getSize() const
+    {
+        return size_;
+    }
+
+    void clear()
+    {
+        for (int c = 0; c < nofChannels_; c++)
+        {
+            channels_[c].clear();
+        }
+    }
+
+    void copyFrom(AudioBuffer& other)
+    {
+        for (int c = 0; c < nofChannels_; c++)
+        {
+            channels_[c].copyFrom(other.channels_[c]);
+        }
+    }
+
+    void add(AudioBuffer& other)
+    {
+        for (int c = 0; c < nofChannels_; c++)
+        {
+            channels_[c].add(other.channels_[c]);
+        }
+    }
+
+    void add(float scalar)
+    {
+        for (int c = 0; c < nofChannels_; c++)
+        {
+            channels_[c].add(scalar);
+        }
+    }
+
+    void multiply(AudioBuffer& other)
+    {
+        for (int c = 0; c < nofChannels_; c++)
+        {
+            channels_[c].multiply(other.channels_[c]);
+        }
+    }
+
+    void multiply(float scalar)
+    {
+        for (int c = 0; c < nofChannels_; c++)
+        {
+            channels_[c].multiply(scalar);
+        }
+    }
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+// Host stand-in of the OWL BiquadFilter, one stage, transposed direct
+// form II. Coefficients from the RBJ audio EQ cookbook, the shelves have
+// a slope of 1 and gains in dB.
+
+#include "basicmaths.h"
+#include "FloatArray.h"
+
+class FilterStage
+{
+public:
+    static constexpr float BUTTERWORTH_Q = 0.70710678f;
+    static constexpr float SALLEN_KEY_Q = 0.5f;
+};
+
+class BiquadFilter
+{
+private:
+    float sampleRate_;
+    float b0_, b1_, b2_, a1_, a2_;
+    float z1_, z2_;
+
+    void setCoefficients(double b0, double b1, double b2, double a0, double a1, double a2)
+    {
+        b0_ = b0 / a0;
+        b1_ = b1 / a0;
+        b2_ = b2 / a0;
+        a1_ = a1 / a0;
+        a2_ = a2 / a0;
+    }
+
+    double omega(float frequency)
+    {
+        return 2 * M_PI * frequency / sampleRate_;
+    }
+
+public:
+    BiquadFilter(float sampleRate) : sampleRate_(sampleRate), b0_(1), b1_(0), b2_(0), a1_(0), a2_(0), z1_(0), z2_(0) {}
+    ~BiquadFilter() {}
+
+    static BiquadFilter* create(float sampleRate, size_t stages = 1)
+    {
+        return new BiquadFilter(sampleRate);
+    }
+
+    static void destroy(BiquadFilter* obj)
+    {
+        delete obj;
+    }
+
+    void setLowPass(float frequency, float q)
+    {
+        double w = omega(frequency), c = cos(w), alpha = sin(w) / (2 * q);
+        setCoefficients((1 - c) / 2, 1 - c, (1 - c) / 2, 1 + alpha, -2 * c, 1 - alpha);
+    }
+
+    void setHighPass(float frequency, float q)
+    {
+        double w = omega(frequency), c = cos(w), alpha = sin(w) / (2 * q);
+        setCoefficients((1 + c) / 2, -(1 + c), (1 + c) / 2, 1 + alpha, -2 * c, 1 - alpha);
+    }
+
+    void setBandPass(float frequency, float q)
+    {
+        double w = omega(frequency), c = cos(w), alpha = sin(w) / (2 * q);
+        setCoefficients(alpha, 0, -alpha, 1 + alpha, -2 * c, 1 - alpha);
+    }
+
+    void setNotch(float frequency, float q)
+    {
+        double w = omega(frequency), c = cos(w), alpha = sin(w) / (2 * q);
+        setCoefficients(1, -2 * c, 1, 1 + alpha, -2 * c, 1 - alpha);
+    }
+
+    void setPeak(float frequency, float q, float gain)
+    {
+        double a = pow(10, gain / 40), w = omega(frequency), c = cos(w), alpha = sin(w) / (2 * q);
+        setCoefficients(1 + alpha * a, -2 * c, 1 - alpha * a, 1 + alpha / a, -2 * c, 1 - alpha / a);
+    }
+
+    void setLowShelf(float frequency, float gain)
+    {
+        double a = pow(10, gain / 40), w = omega(frequency), c = cos(w);
+        double beta = sin(w) * sqrt(a) / M_SQRT2 * 2;
+        setCoefficients(a * ((a + 1) - (a - 1) * c + beta), 2 * a * ((a - 1) - (a + 1) * c), a * ((a + 1) - (a - 1) * c - beta),
+            (a + 1) + (a - 1) * c + beta, -2 * ((a - 1) + (a + 1) * c), (a + 1) + (a - 1) * c - beta);
+    }
+
+    void setHighShelf(float frequency, float gain)
+    {
+        double a = pow(10, gain / 40), w = omega(frequency), c = cos(w);
+        double beta = sin(w) * sqrt(a) / M_SQRT2 * 2;
+        setCoefficients(a * ((a + 1) + (a - 1) * c + beta), -2 * a * ((a - 1) + (a + 1) * c), a * ((a + 1) + (a - 1) * c - beta),
+            (a + 1) - (a - 1) * c + beta, 2 * ((a - 1) - (a + 1) * c), (a + 1) - (a - 1) * c - beta);
+    }
+
+    float process(float input)
+    {
+        float output = b0_ * input + z1_;
+        z1_ = b1_ * input - a1_ * output + z2_;
+        z2_ = b2_ * input - a2_ * output;
+
+        return output;
+    }
+
+    void process(FloatArray input, FloatArray output)
+    {
+        for (size_t i = 0; i < input.getSize(); i++)
+        {
+            output[i] = process(input[i]);
+        }
+    }
+};
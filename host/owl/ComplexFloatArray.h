@@ -0,0 +1,55 @@
+#pragma once
+
+// Host stand-in of the OWL ComplexFloatArray.
+
+#include "FloatArray.h"
+
+struct ComplexFloat
+{
+    float re;
+    float im;
+};
+
+class ComplexFloatArray
+{
+private:
+    ComplexFloat* data_;
+    size_t size_;
+
+public:
+    ComplexFloatArray() : data_(NULL), size_(0) {}
+    ComplexFloatArray(ComplexFloat* data, size_t size) : data_(data), size_(size) {}
+
+    static ComplexFloatArray create(size_t size)
+    {
+        ComplexFloatArray array(new ComplexFloat[size], size);
+        array.clear();
+
+        return array;
+    }
+
+    static void destroy(ComplexFloatArray array)
+    {
+        delete[] array.data_;
+    }
+
+    size_t getSize() const
+    {
+        return size_;
+    }
+
+    ComplexFloat* getData()
+    {
+        return data_;
+    }
+
+    ComplexFloat& operator[](size_t index)
+    {
+        return data_[index];
+    }
+
+    void clear()
+    {
+        memset(data_, 0, size_ * sizeof(ComplexFloat));
+    }
+};
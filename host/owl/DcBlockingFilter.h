@@ -0,0 +1,66 @@
+#pragma once
+
+// Host stand-in of the OWL DcBlockingFilter and StereoDcBlockingFilter,
+// y[n] = x[n] - x[n - 1] + lambda * y[n - 1].
+
+#include "SignalProcessor.h"
+#include "AudioBuffer.h"
+
+class DcBlockingFilter : public SignalProcessor
+{
+private:
+    float lambda_;
+    float x1_, y1_;
+
+public:
+    DcBlockingFilter(float lambda = 0.995f) : lambda_(lambda), x1_(0), y1_(0) {}
+    ~DcBlockingFilter() {}
+
+    static DcBlockingFilter* create(float lambda = 0.995f)
+    {
+        return new DcBlockingFilter(lambda);
+    }
+
+    static void destroy(DcBlockingFilter* obj)
+    {
+        delete obj;
+    }
+
+    float process(float input) override
+    {
+        y1_ = input - x1_ + lambda_ * y1_;
+        x1_ = input;
+
+        return y1_;
+    }
+
+    using SignalProcessor::process;
+};
+
+class StereoDcBlockingFilter
+{
+private:
+    DcBlockingFilter filters_[2];
+
+public:
+    StereoDcBlockingFilter(float lambda = 0.995f) : filters_{DcBlockingFilter(lambda), DcBlockingFilter(lambda)} {}
+    ~StereoDcBlockingFilter() {}
+
+    static StereoDcBlockingFilter* create(float lambda = 0.995f)
+    {
+        return new StereoDcBlockingFilter(lambda);
+    }
+
+    static void destroy(StereoDcBlockingFilter* obj)
+    {
+        delete obj;
+    }
+
+    void process(AudioBuffer& input, AudioBuffer& output)
+    {
+        for (int c = 0; c < 2; c++)
+        {
+            filters_[c].process(input.getSamples(c), output.getSamples(c));
+        }
+    }
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+// Host stand-in of the OWL FastFourierTransform, with the layout and the
+// scaling of arm_rfft_fast_f32:
+// - the spectrum of a real block of size N is packed in N floats: the DC and
+//   the Nyquist bins (both real) first, then re/im of the bins 1 to N/2 - 1
+// - the inverse transform is scaled by 1/N, ifft(fft(x)) == x
+// - both transforms use their input as scratch, its content is undefined
+//   afterwards
+// The real transform runs as a complex one of size N/2 plus a split step.
+
+#include "ComplexFloatArray.h"
+#include <vector>
+#include <assert.h>
+
+class FastFourierTransform
+{
+private:
+    size_t size_;
+    std::vector<float> twiddles_; // e^(-2pi i j / (N/2)), interleaved re/im
+    std::vector<float> splits_; // e^(-2pi i k / N), interleaved re/im
+    std::vector<size_t> reversed_;
+
+    // In place radix-2 transform of N/2 interleaved complex values.
+    void complexTransform(float* data, bool inverse)
+    {
+        const size_t n = size_ / 2;
+        for (size_t i = 0; i < n; i++)
+        {
+            size_t j = reversed_[i];
+            if (i < j)
+            {
+                float re = data[2 * i];
+                float im = data[2 * i + 1];
+                data[2 * i] = data[2 * j];
+                data[2 * i + 1] = data[2 * j + 1];
+                data[2 * j] = re;
+                data[2 * j + 1] = im;
+            }
+        }
+
+        const float sign = inverse ? -1.f : 1.f;
+        for (size_t length = 2; length <= n; length *= 2)
+        {
+            const size_t half = length / 2;
+            const size_t stride = n / length;
+            for (size_t i = 0; i < n; i += length)
+            {
+                for (size_t j = 0; j < half; j++)
+                {
+                    float wr = twiddles_[2 * j * stride];
+                    float wi = twiddles_[2 * j * stride + 1] * sign;
+                    float* a = data + 2 * (i + j);
+                    float* b = data + 2 * (i + j + half);
+                    float br = b[0] * wr - b[1] * wi;
+                    float bi = b[0] * wi + b[1] * wr;
+                    b[0] = a[0] - br;
+                    b[1] = a[1] - bi;
+                    a[0] += br;
+                    a[1] += bi;
+                }
+            }
+        }
+    }
+
+public:
+    FastFourierTransform(size_t size) : size_(size)
+    {
+        assert(size >= 4 && (size & (size - 1)) == 0);
+
+        const size_t n = size / 2;
+        twiddles_.resize(n);
+        for (size_t j = 0; j < n / 2; j++)
+        {
+            double a = -2 * M_PI * j / n;
+            twiddles_[2 * j] = cos(a);
+            twiddles_[2 * j + 1] = sin(a);
+        }
+        splits_.resize(size);
+        for (size_t k = 0; k < n; k++)
+        {
+            double a = -2 * M_PI * k / size;
+            splits_[2 * k] = cos(a);
+            splits_[2 * k + 1] = sin(a);
+        }
+        reversed_.resize(n);
+        int bits = 0;
+        while ((size_t(1) << bits) < n)
+        {
+            bits++;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            size_t r = 0;
+            for (int b = 0; b < bits; b++)
+            {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            reversed_[i] = r;
+        }
+    }
+    ~FastFourierTransform() {}
+
+    static FastFourierTransform* create(size_t size)
+    {
+        return new FastFourierTransform(size);
+    }
+
+    static void destroy(FastFourierTransform* obj)
+    {
+        delete obj;
+    }
+
+    size_t getSize() const
+    {
+        return size_;
+    }
+
+    void fft(FloatArray input, ComplexFloatArray output)
+    {
+        assert(input.getSize() >= size_ && output.getSize() * 2 >= size_);
+
+        // The even and odd samples are the real and imaginary parts of a
+        // complex block of half the size.
+        float* z = input.getData();
+        complexTransform(z, false);
+
+        const size_t n = size_ / 2;
+        float* x = (float*)output.getData();
+        x[0] = z[0] + z[1];
+        x[1] = z[0] - z[1];
+        for (size_t k = 1; k < n; k++)
+        {
+            // Split the transforms of the even and the odd samples.
+            const float* a = z + 2 * k;
+            const float* b = z + 2 * (n - k);
+            float er = 0.5f * (a[0] + b[0]);
+            float ei = 0.5f * (a[1] - b[1]);
+            float or_ = 0.5f * (a[1] + b[1]);
+            float oi = -0.5f * (a[0] - b[0]);
+            float wr = splits_[2 * k];
+            float wi = splits_[2 * k + 1];
+            x[2 * k] = er + or_ * wr - oi * wi;
+            x[2 * k + 1] = ei + or_ * wi + oi * wr;
+        }
+    }
+
+    void ifft(ComplexFloatArray input, FloatArray output)
+    {
+        assert(input.getSize() * 2 >= size_ && output.getSize() >= size_);
+
+        const size_t n = size_ / 2;
+        float* x = (float*)input.getData();
+
+        // Rebuild the complex transform from the half spectrum, two bins
+        // at a time so that it can be done in place.
+        float dc = x[0];
+        float nyquist = x[1];
+        x[0] = 0.5f * (dc + nyquist);
+        x[1] = 0.5f * (dc - nyquist);
+        for (size_t k = 1; k <= n / 2; k++)
+        {
+            float* a = x + 2 * k;
+            float* b = x + 2 * (n - k);
+            float ar = a[0], ai = a[1], br = b[0], bi = b[1];
+
+            // Bin k.
+            float er = 0.5f * (ar + br);
+            float ei = 0.5f * (ai - bi);
+            float dr = 0.5f * (ar - br);
+            float di = 0.5f * (ai + bi);
+            float wr = splits_[2 * k];
+            float wi = -splits_[2 * k + 1];
+            float or_ = dr * wr - di * wi;
+            float oi = dr * wi + di * wr;
+
+            // Bin n - k, its conjugate pair.
+            float er2 = er;
+            float ei2 = -ei;
+            float dr2 = -dr;
+            float di2 = di;
+            float wr2 = splits_[2 * (n - k)];
+            float wi2 = -splits_[2 * (n - k) + 1];
+            float or2 = dr2 * wr2 - di2 * wi2;
+            float oi2 = dr2 * wi2 + di2 * wr2;
+
+            a[0] = er - oi;
+            a[1] = ei + or_;
+            b[0] = er2 - oi2;
+            b[1] = ei2 + or2;
+        }
+
+        complexTransform(x, true);
+
+        const float scale = 1.f / n;
+        float* y = output.getData();
+        for (size_t i = 0; i < size_; i++)
+        {
+            y[i] = x[i] * scale;
+        }
+    }
+};
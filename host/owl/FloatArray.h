@@ -0,0 +1,239 @@
+#pragma once
+
+// Host stand-in of the OWL FloatArray: a non-owning view on a float buffer,
+// allocated and freed explicitly with create() and destroy().
+
+#include <string.h>
+#include <stddef.h>
+#include <cmath>
+
+class FloatArray
+{
+private:
+    float* data_;
+    size_t size_;
+
+public:
+    FloatArray() : data_(NULL), size_(0) {}
+    FloatArray(float* data, size_t size) : data_(data), size_(size) {}
+
+    static FloatArray create(size_t size)
+    {
+        FloatArray array(new float[size], size);
+        array.clear();
+
+        return array;
+    }
+
+    static void destroy(FloatArray array)
+    {
+        delete[] array.data_;
+    }
+
+    size_t getSize() const
+    {
+        return size_;
+    }
+
+    float* getData()
+    {
+        return data_;
+    }
+
+    const float* getData() const
+    {
+        return data_;
+    }
+
+    operator float*()
+    {
+        return data_;
+    }
+
+    float& operator[](size_t index)
+    {
+        return data_[index];
+    }
+
+    const float& operator[](size_t index) const
+    {
+        return data_[index];
+    }
+
+    float getElement(size_t index) const
+    {
+        return data_[index];
+    }
+
+    void setElement(size_t index, float value)
+    {
+        data_[index] = value;
+    }
+
+    FloatArray subArray(size_t offset, size_t length)
+    {
+        return FloatArray(data_ + offset, length);
+    }
+
+    void clear()
+    {
+        memset(data_, 0, size_ * sizeof(float));
+    }
+
+    void setAll(float value)
+    {
+        for (size_t i = 0; i < size_; i++)
+        {
+            data_[i] = value;
+        }
+    }
+
+    // The regions may overlap, as with the firmware's arm_copy_f32 use.
+    void copyFrom(FloatArray source)
+    {
+        memmove(data_, source.data_, getMinSize(source) * sizeof(float));
+    }
+
+    void copyFrom(const float* source, size_t length)
+    {
+        memmove(data_, source, length * sizeof(float));
+    }
+
+    void copyTo(FloatArray destination)
+    {
+        memmove(destination.data_, data_, getMinSize(destination) * sizeof(float));
+    }
+
+    void copyTo(float* destination, size_t length)
+    {
+        memmove(destination, data_, length * sizeof(float));
+    }
+
+    void add(FloatArray operand)
+    {
+        add(operand, *this);
+    }
+
+    void add(FloatArray operand, FloatArray destination)
+    {
+        for (size_t i = 0; i < size_; i++)
+        {
+            destination.data_[i] = data_[i] + operand.data_[i];
+        }
+    }
+
+    void add(float scalar)
+    {
+        for (size_t i = 0; i < size_; i++)
+        {
+            data_[i] += scalar;
+        }
+    }
+
+    void subtract(FloatArray operand)
+    {
+        subtract(operand, *this);
+    }
+
+    void subtract(FloatArray operand, FloatArray destination)
+    {
+        for (size_t i = 0; i < size_; i++)
+        {
+            destination.data_[i] = data_[i] - operand.data_[i];
+        }
+    }
+
+    void multiply(FloatArray operand)
+    {
+        multiply(operand, *this);
+    }
+
+    void multiply(FloatArray operand, FloatArray destination)
+    {
+        for (size_t i = 0; i < size_; i++)
+        {
+            destination.data_[i] = data_[i] * operand.data_[i];
+        }
+    }
+
+    void multiply(float scalar)
+    {
+        multiply(scalar, *this);
+    }
+
+    void multiply(float scalar, FloatArray destination)
+    {
+        for (size_t i = 0; i < size_; i++)
+        {
+            destination.data_[i] = data_[i] * scalar;
+        }
+    }
+
+    void clip(float range = 1.f)
+    {
+        clip(-range, range);
+    }
+
+    void clip(float min, float max)
+    {
+        for (size_t i = 0; i < size_; i++)
+        {
+            data_[i] = data_[i] < min ? min : (data_[i] > max ? max : data_[i]);
+        }
+    }
+
+    float getMinValue() const
+    {
+        float value = size_ ? data_[0] : 0.f;
+        for (size_t i = 1; i < size_; i++)
+        {
+            value = data_[i] < value ? data_[i] : value;
+        }
+
+        return value;
+    }
+
+    float getMaxValue() const
+    {
+        float value = size_ ? data_[0] : 0.f;
+        for (size_t i = 1; i < size_; i++)
+        {
+            value = data_[i] > value ? data_[i] : value;
+        }
+
+        return value;
+    }
+
+    float getMean() const
+    {
+        float sum = 0;
+        for (size_t i = 0; i < size_; i++)
+        {
+            sum += data_[i];
+        }
+
+        return size_ ? sum / size_ : 0.f;
+    }
+
+    float getPower() const
+    {
+        float sum = 0;
+        for (size_t i = 0; i < size_; i++)
+        {
+            sum += data_[i] * data_[i];
+        }
+
+        return sum;
+    }
+
+    float getRms() const
+    {
+        return size_ ? sqrtf(getPower() / size_) : 0.f;
+    }
+
+private:
+    size_t getMinSize(FloatArray other) const
+    {
+        return size_ < other.size_ ? size_ : other.size_;
+    }
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+// Host stand-in of the OWL Interpolator.
+
+#include "basicmaths.h"
+
+class Interpolator
+{
+public:
+    static float linear(float y1, float y2, float mu)
+    {
+        return y1 + mu * (y2 - y1);
+    }
+
+    static float cosine(float y1, float y2, float mu)
+    {
+        float mu2 = (1 - cosf(mu * M_PI)) / 2;
+
+        return y1 * (1 - mu2) + y2 * mu2;
+    }
+};
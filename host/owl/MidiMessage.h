@@ -0,0 +1,145 @@
+#pragma once
+
+// Host stand-in of the OWL MidiMessage and the MIDI status constants: a USB
+// MIDI packet, the port byte first.
+
+#include <stdint.h>
+
+enum MidiStatus
+{
+    NOTE_OFF = 0x80,
+    NOTE_ON = 0x90,
+    POLY_KEY_PRESSURE = 0xA0,
+    CONTROL_CHANGE = 0xB0,
+    PROGRAM_CHANGE = 0xC0,
+    CHANNEL_PRESSURE = 0xD0,
+    PITCH_BEND_CHANGE = 0xE0,
+    TIME_CLOCK = 0xF8,
+    START = 0xFA,
+    CONTINUE = 0xFB,
+    STOP = 0xFC,
+    MIDI_STATUS_MASK = 0xF0,
+    MIDI_CHANNEL_MASK = 0x0F,
+};
+
+enum UsbMidi
+{
+    USB_COMMAND_NOTE_OFF = 0x08,
+    USB_COMMAND_NOTE_ON = 0x09,
+    USB_COMMAND_CONTROL_CHANGE = 0x0B,
+    USB_COMMAND_PROGRAM_CHANGE = 0x0C,
+    USB_COMMAND_CHANNEL_PRESSURE = 0x0D,
+    USB_COMMAND_PITCH_BEND_CHANGE = 0x0E,
+    USB_COMMAND_SINGLE_BYTE = 0x0F,
+};
+
+class MidiMessage
+{
+public:
+    uint8_t data[4];
+
+    MidiMessage()
+    {
+        data[0] = data[1] = data[2] = data[3] = 0;
+    }
+
+    MidiMessage(uint8_t port, uint8_t d0, uint8_t d1, uint8_t d2)
+    {
+        data[0] = port;
+        data[1] = d0;
+        data[2] = d1;
+        data[3] = d2;
+    }
+
+    uint8_t getPort() const
+    {
+        return (data[0] & 0xF0) >> 4;
+    }
+
+    uint8_t getChannel() const
+    {
+        return data[1] & MIDI_CHANNEL_MASK;
+    }
+
+    uint8_t getStatus() const
+    {
+        return data[1] & MIDI_STATUS_MASK;
+    }
+
+    uint8_t getNote() const
+    {
+        return data[2];
+    }
+
+    uint8_t getVelocity() const
+    {
+        return data[3];
+    }
+
+    uint8_t getControllerNumber() const
+    {
+        return data[2];
+    }
+
+    uint8_t getControllerValue() const
+    {
+        return data[3];
+    }
+
+    uint8_t getChannelPressure() const
+    {
+        return data[2];
+    }
+
+    int16_t getPitchBend() const
+    {
+        return ((data[3] << 7) | data[2]) - 8192;
+    }
+
+    bool isNoteOn() const
+    {
+        return getStatus() == NOTE_ON && getVelocity() != 0;
+    }
+
+    bool isNoteOff() const
+    {
+        return getStatus() == NOTE_OFF || (getStatus() == NOTE_ON && getVelocity() == 0);
+    }
+
+    bool isControlChange() const
+    {
+        return getStatus() == CONTROL_CHANGE;
+    }
+
+    bool isChannelPressure() const
+    {
+        return getStatus() == CHANNEL_PRESSURE;
+    }
+
+    bool isPitchBend() const
+    {
+        return getStatus() == PITCH_BEND_CHANGE;
+    }
+
+    static MidiMessage cc(uint8_t ch, uint8_t cc, uint8_t value)
+    {
+        return MidiMessage(USB_COMMAND_CONTROL_CHANGE, CONTROL_CHANGE | (ch & 0xF), cc & 0x7F, value & 0x7F);
+    }
+
+    static MidiMessage cp(uint8_t ch, uint8_t value)
+    {
+        return MidiMessage(USB_COMMAND_CHANNEL_PRESSURE, CHANNEL_PRESSURE | (ch & 0xF), value & 0x7F, 0);
+    }
+
+    static MidiMessage pb(uint8_t ch, int16_t bend)
+    {
+        bend += 8192;
+
+        return MidiMessage(USB_COMMAND_PITCH_BEND_CHANGE, PITCH_BEND_CHANGE | (ch & 0xF), bend & 0x7F, (bend >> 7) & 0x7F);
+    }
+
+    static MidiMessage note(uint8_t ch, uint8_t note, uint8_t velocity)
+    {
+        return MidiMessage(USB_COMMAND_NOTE_ON, NOTE_ON | (ch & 0xF), note & 0x7F, velocity & 0x7F);
+    }
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+// Host stand-in of the OWL MorphingOscillator: crossfades between the two
+// oscillators nearest to the morph position, all of them run all the time.
+
+#include "Oscillator.h"
+
+class MorphingOscillator : public Oscillator
+{
+private:
+    Oscillator** oscillators_;
+    size_t count_;
+    float morph_;
+
+public:
+    MorphingOscillator(size_t count, size_t blockSize) : count_(count), morph_(0)
+    {
+        oscillators_ = new Oscillator*[count];
+        for (size_t i = 0; i < count; i++)
+        {
+            oscillators_[i] = NULL;
+        }
+    }
+    ~MorphingOscillator()
+    {
+        for (size_t i = 0; i < count_; i++)
+        {
+            delete oscillators_[i];
+        }
+        delete[] oscillators_;
+    }
+
+    static MorphingOscillator* create(size_t count, size_t blockSize)
+    {
+        return new MorphingOscillator(count, blockSize);
+    }
+
+    static void destroy(MorphingOscillator* obj)
+    {
+        delete obj;
+    }
+
+    void setOscillator(size_t index, Oscillator* oscillator)
+    {
+        oscillators_[index] = oscillator;
+    }
+
+    Oscillator* getOscillator(size_t index)
+    {
+        return oscillators_[index];
+    }
+
+    /**
+     * @param value 0 - 1 over all the oscillators
+     */
+    void morph(float value)
+    {
+        morph_ = value < 0 ? 0 : (value > 1 ? 1 : value);
+    }
+
+    void setFrequency(float frequency) override
+    {
+        for (size_t i = 0; i < count_; i++)
+        {
+            oscillators_[i]->setFrequency(frequency);
+        }
+    }
+
+    float getFrequency() override
+    {
+        return oscillators_[0]->getFrequency();
+    }
+
+    void setPhase(float phase) override
+    {
+        for (size_t i = 0; i < count_; i++)
+        {
+            oscillators_[i]->setPhase(phase);
+        }
+    }
+
+    float getPhase() override
+    {
+        return oscillators_[0]->getPhase();
+    }
+
+    void reset() override
+    {
+        for (size_t i = 0; i < count_; i++)
+        {
+            oscillators_[i]->reset();
+        }
+    }
+
+    float generate() override
+    {
+        float pos = morph_ * (count_ - 1);
+        size_t index = pos;
+        if (index >= count_ - 1)
+        {
+            index = count_ - 2;
+        }
+        float frac = pos - index;
+
+        float sample = 0;
+        for (size_t i = 0; i < count_; i++)
+        {
+            float s = oscillators_[i]->generate();
+            if (i == index)
+            {
+                sample += s * (1 - frac);
+            }
+            else if (i == index + 1)
+            {
+                sample += s * frac;
+            }
+        }
+
+        return sample;
+    }
+
+    using Oscillator::generate;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+// Host stand-in of the OWL NoiseOscillator: a new random value in [-1, 1]
+// at each period, held in between (sample and hold at the frequency).
+
+#include "Oscillator.h"
+
+class NoiseOscillator : public OscillatorTemplate<NoiseOscillator>
+{
+private:
+    float value_;
+
+public:
+    static constexpr float begin_phase = 0;
+    static constexpr float end_phase = 1;
+
+    NoiseOscillator(float sampleRate) : OscillatorTemplate(sampleRate), value_(0) {}
+
+    static NoiseOscillator* create(float sampleRate)
+    {
+        return new NoiseOscillator(sampleRate);
+    }
+
+    static void destroy(NoiseOscillator* obj)
+    {
+        delete obj;
+    }
+
+    float getSample()
+    {
+        if (phase < incr)
+        {
+            value_ = randf() * 2 - 1;
+        }
+
+        return value_;
+    }
+};
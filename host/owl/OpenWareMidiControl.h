@@ -0,0 +1,49 @@
+#pragma once
+
+// Host stand-in of the OWL parameter and button ids.
+
+enum PatchParameterId
+{
+    PARAMETER_A,
+    PARAMETER_B,
+    PARAMETER_C,
+    PARAMETER_D,
+    PARAMETER_E,
+    PARAMETER_F,
+    PARAMETER_G,
+    PARAMETER_H,
+    PARAMETER_AA,
+    PARAMETER_AB,
+    PARAMETER_AC,
+    PARAMETER_AD,
+    PARAMETER_AE,
+    PARAMETER_AF,
+    PARAMETER_AG,
+    PARAMETER_AH,
+    PARAMETER_BA,
+    PARAMETER_BB,
+    PARAMETER_BC,
+    PARAMETER_BD,
+    PARAMETER_BE,
+    PARAMETER_BF,
+    PARAMETER_BG,
+    PARAMETER_BH,
+    NOF_PARAMETERS
+};
+
+enum PatchButtonId
+{
+    BYPASS_BUTTON,
+    PUSHBUTTON,
+    GREEN_BUTTON,
+    RED_BUTTON,
+    BUTTON_1,
+    BUTTON_2,
+    BUTTON_3,
+    BUTTON_4,
+    BUTTON_5,
+    BUTTON_6,
+    BUTTON_7,
+    BUTTON_8,
+    NOF_BUTTONS
+};
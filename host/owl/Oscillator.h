@@ -0,0 +1,115 @@
+#pragma once
+
+// Host stand-in of the OWL Oscillator, OscillatorTemplate and
+// PhaseShiftOscillator. Subclasses of OscillatorTemplate provide
+// getSample() over the phase range [begin_phase, end_phase).
+
+#include "basicmaths.h"
+#include "SignalGenerator.h"
+
+class Oscillator : public SignalGenerator
+{
+public:
+    virtual ~Oscillator() {}
+
+    virtual void setSampleRate(float sampleRate) {}
+    virtual void setFrequency(float frequency) = 0;
+    virtual float getFrequency() = 0;
+    virtual void setPhase(float phase) = 0;
+    virtual float getPhase() = 0;
+    virtual void reset() = 0;
+
+    using SignalGenerator::generate;
+};
+
+template <class T>
+class OscillatorTemplate : public Oscillator
+{
+protected:
+    float mul;
+    float phase;
+    float incr;
+
+public:
+    OscillatorTemplate() : mul(0), phase(0), incr(0) {}
+    OscillatorTemplate(float sampleRate) : mul((T::end_phase - T::begin_phase) / sampleRate), phase(T::begin_phase), incr(0) {}
+
+    void setSampleRate(float sampleRate) override
+    {
+        float frequency = getFrequency();
+        mul = (T::end_phase - T::begin_phase) / sampleRate;
+        setFrequency(frequency);
+    }
+
+    void setFrequency(float frequency) override
+    {
+        incr = frequency * mul;
+    }
+
+    float getFrequency() override
+    {
+        return mul == 0 ? 0 : incr / mul;
+    }
+
+    void setPhase(float ph) override
+    {
+        phase = T::begin_phase + ph * (T::end_phase - T::begin_phase) / (2 * M_PI);
+    }
+
+    float getPhase() override
+    {
+        return (phase - T::begin_phase) * 2 * M_PI / (T::end_phase - T::begin_phase);
+    }
+
+    void reset() override
+    {
+        phase = T::begin_phase;
+    }
+
+    float generate() override
+    {
+        float sample = static_cast<T*>(this)->getSample();
+        phase += incr;
+        if (phase >= T::end_phase)
+        {
+            phase -= T::end_phase - T::begin_phase;
+        }
+
+        return sample;
+    }
+
+    using Oscillator::generate;
+};
+
+/**
+ * @brief Oscillator that starts from a phase offset, kept through
+ *        reset().
+ */
+template <class O>
+class PhaseShiftOscillator : public O
+{
+private:
+    float offset_;
+
+public:
+    PhaseShiftOscillator(float offset, float sampleRate) : O(sampleRate), offset_(offset)
+    {
+        reset();
+    }
+
+    static PhaseShiftOscillator* create(float offset, float sampleRate)
+    {
+        return new PhaseShiftOscillator(offset, sampleRate);
+    }
+
+    static void destroy(PhaseShiftOscillator* obj)
+    {
+        delete obj;
+    }
+
+    void reset() override
+    {
+        O::reset();
+        O::setPhase(O::getPhase() + offset_);
+    }
+};
@@ -0,0 +1,126 @@
+#include "Patch.h"
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+static PatchProcessor processor;
+
+PatchProcessor* getInitialisingPatchProcessor()
+{
+    return &processor;
+}
+
+// The patch memory is zeroed, as on a freshly started device: some of the
+// patch state is never initialized explicitly and the renders must not depend
+// on whatever the host heap holds.
+void* operator new(size_t size)
+{
+    return calloc(1, size ? size : 1);
+}
+
+void* operator new[](size_t size)
+{
+    return calloc(1, size ? size : 1);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t size) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t size) noexcept
+{
+    free(ptr);
+}
+
+PatchProcessor::PatchProcessor()
+{
+    patch = NULL;
+    sampleRate = 48000;
+    blockSize = 64;
+    for (int i = 0; i < NOF_PARAMETERS; i++)
+    {
+        parameters[i] = 0;
+        parameterOutputs[i] = 0;
+    }
+    for (int i = 0; i < NOF_BUTTONS; i++)
+    {
+        buttons[i] = 0;
+        buttonOutputs[i] = 0;
+    }
+    midiMessagesSent = 0;
+}
+
+void PatchProcessor::setButton(PatchButtonId bid, uint16_t value, uint16_t samples)
+{
+    if (buttons[bid] != value)
+    {
+        buttons[bid] = value;
+        if (patch != NULL)
+        {
+            patch->buttonChanged(bid, value, samples);
+        }
+    }
+}
+
+Patch::Patch()
+{
+    // The patch constructor already reaches the processor through
+    // getInitialisingPatchProcessor()->patch.
+    processor.patch = this;
+}
+
+Patch::~Patch()
+{
+    processor.patch = NULL;
+}
+
+float Patch::getParameterValue(PatchParameterId pid)
+{
+    return processor.parameters[pid];
+}
+
+void Patch::setParameterValue(PatchParameterId pid, float value)
+{
+    processor.parameterOutputs[pid] = value;
+}
+
+bool Patch::isButtonPressed(PatchButtonId bid)
+{
+    return processor.buttons[bid] != 0;
+}
+
+void Patch::setButton(PatchButtonId bid, uint16_t value, uint16_t samples)
+{
+    processor.buttonOutputs[bid] = value;
+}
+
+void Patch::sendMidi(MidiMessage msg)
+{
+    processor.midiMessagesSent++;
+}
+
+int Patch::getBlockSize()
+{
+    return processor.blockSize;
+}
+
+float Patch::getSampleRate()
+{
+    return processor.sampleRate;
+}
+
+float Patch::getBlockRate()
+{
+    return processor.sampleRate / processor.blockSize;
+}
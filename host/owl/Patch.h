@@ -0,0 +1,75 @@
+#pragma once
+
+// Host stand-in of the OWL Patch. The host drives the patch through the
+// PatchProcessor: it sets the parameters and the buttons, then calls
+// processAudio() once per block.
+
+#include "basicmaths.h"
+#include "message.h"
+#include "FloatArray.h"
+#include "ComplexFloatArray.h"
+#include "AudioBuffer.h"
+#include "Resource.h"
+#include "OpenWareMidiControl.h"
+#include "MidiMessage.h"
+#include <stdint.h>
+
+class Patch;
+
+class PatchProcessor
+{
+public:
+    Patch* patch;
+
+    float sampleRate;
+    int blockSize;
+
+    // Parameters and buttons set by the host.
+    float parameters[NOF_PARAMETERS];
+    uint16_t buttons[NOF_BUTTONS];
+
+    // Values set by the patch (LEDs, gates).
+    float parameterOutputs[NOF_PARAMETERS];
+    uint16_t buttonOutputs[NOF_BUTTONS];
+
+    int midiMessagesSent;
+
+    PatchProcessor();
+
+    /**
+     * @brief Sets a button and notifies the patch if it changed.
+     *
+     * @param samples Offset of the change in the next block
+     */
+    void setButton(PatchButtonId bid, uint16_t value, uint16_t samples = 0);
+};
+
+/**
+ * @brief The processor of the patch being created or run, there's only one
+ *        on the host.
+ */
+PatchProcessor* getInitialisingPatchProcessor();
+
+class Patch
+{
+public:
+    Patch();
+    virtual ~Patch();
+
+    void registerParameter(PatchParameterId pid, const char* name) {}
+
+    // Like the firmware, these don't use the patch instance.
+    float getParameterValue(PatchParameterId pid);
+    void setParameterValue(PatchParameterId pid, float value);
+    bool isButtonPressed(PatchButtonId bid);
+    void setButton(PatchButtonId bid, uint16_t value, uint16_t samples = 0);
+    void sendMidi(MidiMessage msg);
+
+    int getBlockSize();
+    float getSampleRate();
+    float getBlockRate();
+
+    virtual void processAudio(AudioBuffer& audio) = 0;
+    virtual void buttonChanged(PatchButtonId bid, uint16_t value, uint16_t samples) {}
+    virtual void processMidi(MidiMessage msg) {}
+};
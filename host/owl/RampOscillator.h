@@ -0,0 +1,56 @@
+#pragma once
+
+// Host stand-in of the OWL RampOscillator and InvertedRampOscillator,
+// naive (not band limited) -1 to 1 ramps.
+
+#include "Oscillator.h"
+
+class RampOscillator : public OscillatorTemplate<RampOscillator>
+{
+public:
+    static constexpr float begin_phase = 0;
+    static constexpr float end_phase = 1;
+
+    RampOscillator() {}
+    RampOscillator(float sampleRate) : OscillatorTemplate(sampleRate) {}
+
+    static RampOscillator* create(float sampleRate)
+    {
+        return new RampOscillator(sampleRate);
+    }
+
+    static void destroy(RampOscillator* obj)
+    {
+        delete obj;
+    }
+
+    float getSample()
+    {
+        return phase * 2 - 1;
+    }
+};
+
+class InvertedRampOscillator : public OscillatorTemplate<InvertedRampOscillator>
+{
+public:
+    static constexpr float begin_phase = 0;
+    static constexpr float end_phase = 1;
+
+    InvertedRampOscillator() {}
+    InvertedRampOscillator(float sampleRate) : OscillatorTemplate(sampleRate) {}
+
+    static InvertedRampOscillator* create(float sampleRate)
+    {
+        return new InvertedRampOscillator(sampleRate);
+    }
+
+    static void destroy(InvertedRampOscillator* obj)
+    {
+        delete obj;
+    }
+
+    float getSample()
+    {
+        return 1 - phase * 2;
+    }
+};
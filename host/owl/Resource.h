@@ -0,0 +1,105 @@
+#pragma once
+
+// Host stand-in of the OWL Resource: resources are read from files named
+// after them, in the directory set with setPath() (the current directory by
+// default).
+
+#include "FloatArray.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+
+class Resource
+{
+private:
+    std::string name_;
+    uint8_t* data_;
+    size_t size_;
+
+    static std::string& path()
+    {
+        static std::string path = ".";
+
+        return path;
+    }
+
+public:
+    Resource(const char* name, uint8_t* data, size_t size) : name_(name), data_(data), size_(size) {}
+    ~Resource()
+    {
+        delete[] data_;
+    }
+
+    static void setPath(const char* directory)
+    {
+        path() = directory;
+    }
+
+    /**
+     * @return NULL if there's no such file
+     */
+    static Resource* load(const char* name)
+    {
+        std::string file = path() + "/" + name;
+        FILE* f = fopen(file.c_str(), "rb");
+        if (f == NULL)
+        {
+            return NULL;
+        }
+
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        uint8_t* data = new uint8_t[size > 0 ? size : 1];
+        size_t read = size > 0 ? fread(data, 1, size, f) : 0;
+        fclose(f);
+
+        return new Resource(name, data, read);
+    }
+
+    // Like the firmware, destroying a NULL resource is fine.
+    static void destroy(Resource* resource)
+    {
+        delete resource;
+    }
+
+    const char* getName() const
+    {
+        return name_.c_str();
+    }
+
+    size_t getSize() const
+    {
+        return size_;
+    }
+
+    bool hasData() const
+    {
+        return data_ != NULL && size_ > 0;
+    }
+
+    void* getData()
+    {
+        return data_;
+    }
+
+    /**
+     * @brief The data as an array of Element, from offset (in bytes) and
+     *        with at most max_size elements.
+     */
+    template <typename Array, typename Element>
+    Array asArray(size_t offset = 0, size_t max_size = 0xFFFFFFFF)
+    {
+        if (offset > size_)
+        {
+            offset = size_;
+        }
+        size_t size = (size_ - offset) / sizeof(Element);
+        if (size > max_size)
+        {
+            size = max_size;
+        }
+
+        return Array((Element*)(data_ + offset), size);
+    }
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+// Host stand-in of the OWL SignalGenerator.
+
+#include "FloatArray.h"
+
+class SignalGenerator
+{
+public:
+    virtual ~SignalGenerator() {}
+
+    virtual float generate() = 0;
+
+    virtual void generate(FloatArray output)
+    {
+        for (size_t i = 0; i < output.getSize(); i++)
+        {
+            output[i] = generate();
+        }
+    }
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+// Host stand-in of the OWL SignalProcessor.
+
+#include "FloatArray.h"
+
+class SignalProcessor
+{
+public:
+    virtual ~SignalProcessor() {}
+
+    virtual float process(float input) = 0;
+
+    virtual void process(FloatArray input, FloatArray output)
+    {
+        for (size_t i = 0; i < input.getSize(); i++)
+        {
+            output[i] = process(input[i]);
+        }
+    }
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+// Host stand-in of the OWL SineOscillator.
+
+#include "Oscillator.h"
+
+class SineOscillator : public OscillatorTemplate<SineOscillator>
+{
+public:
+    static constexpr float begin_phase = 0;
+    static constexpr float end_phase = 2 * M_PI;
+
+    SineOscillator() {}
+    SineOscillator(float sampleRate) : OscillatorTemplate(sampleRate) {}
+
+    static SineOscillator* create(float sampleRate)
+    {
+        return new SineOscillator(sampleRate);
+    }
+
+    static void destroy(SineOscillator* obj)
+    {
+        delete obj;
+    }
+
+    float getSample()
+    {
+        return sinf(phase);
+    }
+};
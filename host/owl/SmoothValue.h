@@ -0,0 +1,81 @@
+#pragma once
+
+// Host stand-in of the OWL SmoothValue and StiffValue.
+
+template <typename T>
+class SmoothValue
+{
+private:
+    T value_;
+    float lambda_;
+
+public:
+    SmoothValue(float lambda = 0.9f, T value = T()) : value_(value), lambda_(lambda) {}
+
+    void setLambda(float lambda)
+    {
+        lambda_ = lambda;
+    }
+
+    void update(T newValue)
+    {
+        value_ = value_ * lambda_ + newValue * (1 - lambda_);
+    }
+
+    T getValue() const
+    {
+        return value_;
+    }
+
+    SmoothValue<T>& operator=(const T& other)
+    {
+        update(other);
+
+        return *this;
+    }
+
+    operator T() const
+    {
+        return value_;
+    }
+};
+
+typedef SmoothValue<float> SmoothFloat;
+
+template <typename T>
+class StiffValue
+{
+private:
+    T value_;
+    T delta_;
+
+public:
+    StiffValue(T delta = T(0.02), T value = T()) : value_(value), delta_(delta) {}
+
+    void update(T newValue)
+    {
+        if (newValue > value_ + delta_ || newValue < value_ - delta_)
+        {
+            value_ = newValue;
+        }
+    }
+
+    T getValue() const
+    {
+        return value_;
+    }
+
+    StiffValue<T>& operator=(const T& other)
+    {
+        update(other);
+
+        return *this;
+    }
+
+    operator T() const
+    {
+        return value_;
+    }
+};
+
+typedef StiffValue<float> StiffFloat;
@@ -0,0 +1,30 @@
+#pragma once
+
+// Host stand-in of the OWL SquareWaveOscillator, naive -1/1 square.
+
+#include "Oscillator.h"
+
+class SquareWaveOscillator : public OscillatorTemplate<SquareWaveOscillator>
+{
+public:
+    static constexpr float begin_phase = 0;
+    static constexpr float end_phase = 1;
+
+    SquareWaveOscillator() {}
+    SquareWaveOscillator(float sampleRate) : OscillatorTemplate(sampleRate) {}
+
+    static SquareWaveOscillator* create(float sampleRate)
+    {
+        return new SquareWaveOscillator(sampleRate);
+    }
+
+    static void destroy(SquareWaveOscillator* obj)
+    {
+        delete obj;
+    }
+
+    float getSample()
+    {
+        return phase < 0.5f ? 1.f : -1.f;
+    }
+};
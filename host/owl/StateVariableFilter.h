@@ -0,0 +1,83 @@
+#pragma once
+
+// Host stand-in of the OWL StateVariableFilter, a trapezoidal integrated
+// SVF (Zavalishin/Simper).
+
+#include "basicmaths.h"
+#include "SignalProcessor.h"
+
+class StateVariableFilter : public SignalProcessor
+{
+private:
+    enum Mode
+    {
+        MODE_LOW_PASS,
+        MODE_BAND_PASS,
+        MODE_HIGH_PASS,
+    };
+
+    float sampleRate_;
+    float k_, a1_, a2_, a3_;
+    float ic1eq_, ic2eq_;
+    Mode mode_;
+
+    void setCoefficients(float frequency, float q, Mode mode)
+    {
+        float g = tanf(M_PI * frequency / sampleRate_);
+        k_ = 1.f / q;
+        a1_ = 1.f / (1.f + g * (g + k_));
+        a2_ = g * a1_;
+        a3_ = g * a2_;
+        mode_ = mode;
+    }
+
+public:
+    StateVariableFilter(float sampleRate) : sampleRate_(sampleRate), k_(1), a1_(0), a2_(0), a3_(0), ic1eq_(0), ic2eq_(0), mode_(MODE_LOW_PASS) {}
+    ~StateVariableFilter() {}
+
+    static StateVariableFilter* create(float sampleRate)
+    {
+        return new StateVariableFilter(sampleRate);
+    }
+
+    static void destroy(StateVariableFilter* obj)
+    {
+        delete obj;
+    }
+
+    void setLowPass(float frequency, float q)
+    {
+        setCoefficients(frequency, q, MODE_LOW_PASS);
+    }
+
+    void setBandPass(float frequency, float q)
+    {
+        setCoefficients(frequency, q, MODE_BAND_PASS);
+    }
+
+    void setHighPass(float frequency, float q)
+    {
+        setCoefficients(frequency, q, MODE_HIGH_PASS);
+    }
+
+    float process(float input) override
+    {
+        float v3 = input - ic2eq_;
+        float v1 = a1_ * ic1eq_ + a2_ * v3;
+        float v2 = ic2eq_ + a2_ * ic1eq_ + a3_ * v3;
+        ic1eq_ = 2 * v1 - ic1eq_;
+        ic2eq_ = 2 * v2 - ic2eq_;
+
+        switch (mode_)
+        {
+        case MODE_BAND_PASS:
+            return v1;
+        case MODE_HIGH_PASS:
+            return input - k_ * v1 - v2;
+        default:
+            return v2;
+        }
+    }
+
+    using SignalProcessor::process;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+// Host stand-in of the OWL TapTempo: clock() counts time in steps, the
+// period is the time between two triggers when shorter than the limit.
+
+#include <stddef.h>
+
+class TapTempo
+{
+private:
+    float sampleRate_;
+    size_t limit_;
+    size_t period_;
+    size_t sinceTrigger_;
+    size_t phase_;
+    bool triggered_;
+
+public:
+    TapTempo(float sampleRate, size_t limit) : sampleRate_(sampleRate), limit_(limit)
+    {
+        period_ = sampleRate;
+        sinceTrigger_ = limit;
+        phase_ = 0;
+        triggered_ = false;
+    }
+    ~TapTempo() {}
+
+    static TapTempo* create(float sampleRate, size_t limit)
+    {
+        return new TapTempo(sampleRate, limit);
+    }
+
+    static void destroy(TapTempo* obj)
+    {
+        delete obj;
+    }
+
+    /**
+     * @param on Trigger state, a rising edge taps
+     * @param delay Unused, the host counts whole steps
+     */
+    void trigger(bool on, int delay = 0)
+    {
+        if (on && !triggered_)
+        {
+            if (sinceTrigger_ < limit_ && sinceTrigger_ > 0)
+            {
+                period_ = sinceTrigger_;
+            }
+            sinceTrigger_ = 0;
+            phase_ = 0;
+        }
+        triggered_ = on;
+    }
+
+    void clock(size_t steps = 1)
+    {
+        if (sinceTrigger_ < limit_)
+        {
+            sinceTrigger_ += steps;
+        }
+        phase_ += steps;
+        if (phase_ >= period_)
+        {
+            phase_ -= period_;
+        }
+    }
+
+    bool isOn() const
+    {
+        return phase_ < period_ / 2;
+    }
+
+    size_t getPeriodInSamples() const
+    {
+        return period_;
+    }
+
+    float getPeriod() const
+    {
+        return period_ / sampleRate_;
+    }
+
+    float getFrequency() const
+    {
+        return sampleRate_ / period_;
+    }
+
+    void setFrequency(float frequency)
+    {
+        period_ = sampleRate_ / frequency;
+        if (period_ < 1)
+        {
+            period_ = 1;
+        }
+    }
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+// Host stand-in of the OWL VoltsPerOctave, with the default calibration.
+
+#include "basicmaths.h"
+
+class VoltsPerOctave
+{
+private:
+    float tune_;
+    float offset_;
+    float multiplier_;
+
+public:
+    VoltsPerOctave(bool input = true) : tune_(0)
+    {
+        offset_ = input ? -0.0585f : 0.0f;
+        multiplier_ = input ? -4.29f : 4.29f;
+    }
+
+    void setTune(float octaves)
+    {
+        tune_ = octaves;
+    }
+
+    float sampleToVolts(float sample)
+    {
+        return (sample - offset_) * multiplier_;
+    }
+
+    float voltsToSample(float volts)
+    {
+        return volts / multiplier_ + offset_;
+    }
+
+    float voltsToHertz(float volts)
+    {
+        return 440.f * exp2f(volts + tune_ - 5.75f);
+    }
+
+    float getFrequency(float sample)
+    {
+        return voltsToHertz(sampleToVolts(sample));
+    }
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+// Host stand-in of the OWL basicmaths.h: the fast_* approximations fall
+// back to libm, like the firmware does on non-ARM targets.
+
+#include <cmath>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/**
+ * @brief Uniform random float in [0, 1]. Seed with srand() for
+ *        reproducible renders.
+ */
+inline float randf()
+{
+    return rand() / (float)RAND_MAX;
+}
+
+inline float fast_powf(float x, float y)
+{
+    return powf(x, y);
+}
+
+inline float fast_expf(float x)
+{
+    return expf(x);
+}
+
+inline float fast_exp2f(float x)
+{
+    return exp2f(x);
+}
+
+inline float fast_logf(float x)
+{
+    return logf(x);
+}
+
+inline float fast_log2f(float x)
+{
+    return log2f(x);
+}
@@ -0,0 +1,217 @@
+// Offline renderer: runs Iroi_1_0_0Patch on a WAV file, block by block,
+// with its parameters, CVs, buttons and sync in driven by an automation file
+// (see Automation.h).
+//
+// Targets are the OWL parameter and button names (PARAMETER_A, BUTTON_4...)
+// or the button names of Commons.h (SYNC_IN, RANDOM_IN, SHIFT_BUTTON...).
+// The CV inputs are parameters too, see ParamController.h for the mapping.
+// Parameters are sampled at the start of each block, buttons change at the
+// exact sample.
+
+#include "Iroi_1_0_0Patch.hpp"
+#include "Wav.h"
+#include "Automation.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+struct RenderTarget
+{
+    const char* name;
+    int parameter;
+    int button;
+};
+
+#define RENDER_PARAMETER(id) { #id, id, -1 }
+#define RENDER_BUTTON(id) { #id, -1, id }
+
+static const RenderTarget kRenderTargets[] = {
+    RENDER_PARAMETER(PARAMETER_A),
+    RENDER_PARAMETER(PARAMETER_B),
+    RENDER_PARAMETER(PARAMETER_C),
+    RENDER_PARAMETER(PARAMETER_D),
+    RENDER_PARAMETER(PARAMETER_E),
+    RENDER_PARAMETER(PARAMETER_F),
+    RENDER_PARAMETER(PARAMETER_G),
+    RENDER_PARAMETER(PARAMETER_H),
+    RENDER_PARAMETER(PARAMETER_AA),
+    RENDER_PARAMETER(PARAMETER_AB),
+    RENDER_PARAMETER(PARAMETER_AC),
+    RENDER_PARAMETER(PARAMETER_AD),
+    RENDER_PARAMETER(PARAMETER_AE),
+    RENDER_PARAMETER(PARAMETER_AF),
+    RENDER_PARAMETER(PARAMETER_AG),
+    RENDER_PARAMETER(PARAMETER_AH),
+    RENDER_PARAMETER(PARAMETER_BA),
+    RENDER_PARAMETER(PARAMETER_BB),
+    RENDER_PARAMETER(PARAMETER_BC),
+    RENDER_PARAMETER(PARAMETER_BD),
+    RENDER_PARAMETER(PARAMETER_BE),
+    RENDER_PARAMETER(PARAMETER_BF),
+    RENDER_PARAMETER(PARAMETER_BG),
+    RENDER_PARAMETER(PARAMETER_BH),
+    RENDER_BUTTON(BUTTON_1),
+    RENDER_BUTTON(BUTTON_2),
+    RENDER_BUTTON(BUTTON_3),
+    RENDER_BUTTON(BUTTON_4),
+    RENDER_BUTTON(BUTTON_5),
+    RENDER_BUTTON(BUTTON_6),
+    RENDER_BUTTON(BUTTON_7),
+    RENDER_BUTTON(BUTTON_8),
+    RENDER_BUTTON(RANDOM_BUTTON),
+    RENDER_BUTTON(MAP_BUTTON),
+    RENDER_BUTTON(RANDOM_IN),
+    RENDER_BUTTON(SYNC_IN),
+    RENDER_BUTTON(SHIFT_BUTTON),
+};
+
+static const RenderTarget* FindTarget(const char* name)
+{
+    for (size_t i = 0; i < sizeof(kRenderTargets) / sizeof(kRenderTargets[0]); i++)
+    {
+        if (!strcmp(kRenderTargets[i].name, name))
+        {
+            return &kRenderTargets[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void Usage()
+{
+    fprintf(stderr,
+        "usage: iroi-render [-a automation] [-b blocksize] [-d resources] [-s seed] in.wav out.wav\n"
+        "  -a  timestamped parameters, CVs and buttons, see Automation.h\n"
+        "  -b  block size, 64 by default\n"
+        "  -d  directory of the resources (iroi.ir...), the current one by default\n"
+        "  -s  seed of the random generator, 1 by default\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* automationPath = NULL;
+    int blockSize = 64;
+    unsigned int seed = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "a:b:d:s:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'a':
+            automationPath = optarg;
+            break;
+        case 'b':
+            blockSize = atoi(optarg);
+            break;
+        case 'd':
+            Resource::setPath(optarg);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            Usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (argc - optind != 2 || blockSize < 1)
+    {
+        Usage();
+        return 1;
+    }
+
+    Wav in;
+    if (!ReadWav(argv[optind], in))
+    {
+        return 1;
+    }
+
+    Automation automation;
+    if (automationPath && !automation.Load(automationPath))
+    {
+        return 1;
+    }
+    std::vector<const RenderTarget*> targets(automation.GetSize());
+    for (size_t i = 0; i < automation.GetSize(); i++)
+    {
+        targets[i] = FindTarget(automation[i].GetName());
+        if (targets[i] == NULL)
+        {
+            fprintf(stderr, "%s: unknown target %s\n", automationPath, automation[i].GetName());
+            return 1;
+        }
+    }
+
+    // The patch reads the sample rate and the block size when created.
+    PatchProcessor* processor = getInitialisingPatchProcessor();
+    processor->sampleRate = in.sampleRate;
+    processor->blockSize = blockSize;
+    srand(seed);
+
+    // The initial values, so that the patch starts where the automation
+    // does.
+    for (size_t i = 0; i < automation.GetSize(); i++)
+    {
+        if (targets[i]->parameter >= 0)
+        {
+            processor->parameters[targets[i]->parameter] = automation[i].Interpolate(0);
+        }
+    }
+
+    Iroi_1_0_0Patch* patch = new Iroi_1_0_0Patch();
+    AudioBuffer* buffer = AudioBuffer::create(2, blockSize);
+
+    Wav out;
+    out.sampleRate = in.sampleRate;
+    out.channels = 2;
+    size_t frames = in.GetFrames();
+    out.samples.resize(frames * 2);
+
+    std::vector<size_t> nextPoints(automation.GetSize(), 0);
+    for (size_t start = 0; start < frames; start += blockSize)
+    {
+        double time = double(start) / in.sampleRate;
+        for (size_t i = 0; i < automation.GetSize(); i++)
+        {
+            const RenderTarget* target = targets[i];
+            const AutomationTrack& track = automation[i];
+            if (target->parameter >= 0)
+            {
+                processor->parameters[target->parameter] = track.Interpolate(time);
+                continue;
+            }
+
+            // Every button change in this block, at its offset.
+            size_t& next = nextPoints[i];
+            while (next < track.GetSize() && track[next].time * in.sampleRate < start + blockSize)
+            {
+                double offset = track[next].time * in.sampleRate - start;
+                uint16_t samples = offset > 0 ? uint16_t(offset) : 0;
+                processor->setButton(PatchButtonId(target->button), track[next].value != 0 ? 4095 : 0, samples);
+                next++;
+            }
+        }
+
+        FloatArray left = buffer->getSamples(LEFT_CHANNEL);
+        FloatArray right = buffer->getSamples(RIGHT_CHANNEL);
+        for (int i = 0; i < blockSize; i++)
+        {
+            size_t frame = start + i;
+            left[i] = frame < frames ? in.Get(frame, 0) : 0.f;
+            right[i] = frame < frames ? in.Get(frame, 1) : 0.f;
+        }
+
+        patch->processAudio(*buffer);
+
+        for (int i = 0; i < blockSize && start + i < frames; i++)
+        {
+            out.samples[2 * (start + i)] = left[i];
+            out.samples[2 * (start + i) + 1] = right[i];
+        }
+    }
+
+    delete patch;
+    AudioBuffer::destroy(buffer);
+
+    return WriteWav(argv[optind + 1], out) ? 0 : 1;
+}